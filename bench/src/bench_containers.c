@@ -0,0 +1,496 @@
+#include <defines.h>
+#include <core/fmemory.h>
+#include <containers/darray.h>
+#include <containers/priority_queue.h>
+#include <containers/lru_cache.h>
+#include <platform/platform.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Container micro-benchmarks.
+ *
+ * Every case is run for each element size and element count, repeated a number of times. Per repetition the
+ * measured region reports ns/op, allocations/op and bytes touched/op, where bytes touched is everything that
+ * went through fmemory (allocated + copied + set). Timings are reported as median and p99 over repetitions.
+ *
+ * Usage: foo_bench_containers [--json] [--quick] [--reps N] [--filter substring]
+ */
+
+#define BENCH_MAX_REPETITIONS 256
+#define BENCH_DEFAULT_REPETITIONS 21
+#define BENCH_MAX_STRIDE 256
+
+static const uint64_t bench_strides[] = {8, 16, 64, 256};
+static const uint64_t bench_counts[] = {64, 1024, 16384};
+
+typedef struct bench_sample
+{
+    float64_t seconds;
+    uint64_t ops;
+    memory_counters delta;
+} bench_sample;
+
+typedef struct bench_timer
+{
+    float64_t start_time;
+    memory_counters start_counters;
+} bench_timer;
+
+typedef void (*ptrfn_bench)(uint64_t stride, uint64_t count, bench_sample* out_sample);
+
+typedef struct bench_case
+{
+    const char* name;
+    ptrfn_bench run;
+} bench_case;
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t bench_random()
+{
+    // xorshift64*:
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1Dull;
+}
+
+static void bench_begin(bench_timer* timer)
+{
+    get_memory_counters(&timer->start_counters);
+    timer->start_time = platform_get_absolute_time();
+}
+
+static void bench_end(const bench_timer* timer, uint64_t ops, bench_sample* out_sample)
+{
+    float64_t end_time = platform_get_absolute_time();
+    memory_counters end_counters;
+    get_memory_counters(&end_counters);
+
+    out_sample->seconds = end_time - timer->start_time;
+    out_sample->ops = ops;
+    out_sample->delta.allocation_count = end_counters.allocation_count - timer->start_counters.allocation_count;
+    out_sample->delta.free_count = end_counters.free_count - timer->start_counters.free_count;
+    out_sample->delta.bytes_allocated = end_counters.bytes_allocated - timer->start_counters.bytes_allocated;
+    out_sample->delta.bytes_copied = end_counters.bytes_copied - timer->start_counters.bytes_copied;
+    out_sample->delta.bytes_set = end_counters.bytes_set - timer->start_counters.bytes_set;
+}
+
+// Fills an element with a random priority in its first 8 bytes; the rest is payload.
+// N.B: Uses libc directly so that preparing elements does not count towards the bytes touched by containers.
+static float64_t bench_make_element(uint8_t* element, uint64_t stride)
+{
+    float64_t priority = (float64_t)(bench_random() % 1000000);
+    memset(element, 0xAB, stride);
+    memcpy(element, &priority, sizeof(float64_t));
+    return priority;
+}
+
+// Pre-generates count elements and their priorities, so preparing them is not part of the measured region:
+static uint8_t* bench_make_elements(uint64_t stride, uint64_t count, float64_t** out_priorities)
+{
+    uint8_t* elements = fallocate(stride * count, MEMORY_TAG_ARRAY);
+    *out_priorities = fallocate(sizeof(float64_t) * count, MEMORY_TAG_ARRAY);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        (*out_priorities)[i] = bench_make_element(elements + (i * stride), stride);
+    }
+    return elements;
+}
+
+static void bench_free_elements(uint8_t* elements, float64_t* priorities, uint64_t stride, uint64_t count)
+{
+    ffree(elements, stride * count, MEMORY_TAG_ARRAY);
+    ffree(priorities, sizeof(float64_t) * count, MEMORY_TAG_ARRAY);
+}
+
+// Pre-generates count random values below limit:
+static uint64_t* bench_make_randoms(uint64_t count, uint64_t limit)
+{
+    uint64_t* values = fallocate(sizeof(uint64_t) * count, MEMORY_TAG_ARRAY);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        values[i] = bench_random() % limit;
+    }
+    return values;
+}
+
+static float64_t bench_element_priority(const void* element)
+{
+    float64_t priority;
+    memcpy(&priority, element, sizeof(float64_t));
+    return priority;
+}
+
+// -- darray --
+
+static void bench_darray_push(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint8_t element[BENCH_MAX_STRIDE];
+    bench_make_element(element, stride);
+    void* array = _darray_create(DARRAY_DEFAULT_CAPACITY, stride);
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _darray_push(&array, element);
+    }
+    bench_end(&timer, count, out_sample);
+
+    _darray_destroy(array);
+}
+
+static void bench_darray_pop(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint8_t element[BENCH_MAX_STRIDE];
+    bench_make_element(element, stride);
+    void* array = _darray_create(count, stride);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _darray_push(&array, element);
+    }
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _darray_pop(&array, element);
+    }
+    bench_end(&timer, count, out_sample);
+
+    _darray_destroy(array);
+}
+
+static void bench_darray_insert_at(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint8_t element[BENCH_MAX_STRIDE];
+    bench_make_element(element, stride);
+    void* array = _darray_create(DARRAY_DEFAULT_CAPACITY, stride);
+    // insert_at requires an existing index:
+    _darray_push(&array, element);
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _darray_insert_at(&array, darray_length(array) / 2, element);
+    }
+    bench_end(&timer, count, out_sample);
+
+    _darray_destroy(array);
+}
+
+static void bench_darray_pop_at(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint8_t element[BENCH_MAX_STRIDE];
+    bench_make_element(element, stride);
+    void* array = _darray_create(count, stride);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _darray_push(&array, element);
+    }
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _darray_pop_at(&array, darray_length(array) / 2, element);
+    }
+    bench_end(&timer, count, out_sample);
+
+    _darray_destroy(array);
+}
+
+// -- Priority queues --
+
+static void bench_priority_queue_push_pop(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint8_t element[BENCH_MAX_STRIDE];
+    float64_t* priorities;
+    uint8_t* elements = bench_make_elements(stride, count, &priorities);
+    priority_queue queue;
+    _priority_queue_create(stride, PRIORITY_QUEUE_DEFAULT_ARITY, PRIORITY_QUEUE_DEFAULT_CAPACITY, &queue);
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _priority_queue_push(&queue, elements + (i * stride), priorities[i]);
+    }
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _priority_queue_pop(&queue, element, 0);
+    }
+    bench_end(&timer, count * 2, out_sample);
+
+    _priority_queue_destroy(&queue);
+    bench_free_elements(elements, priorities, stride, count);
+}
+
+// The ad-hoc alternative: a darray kept sorted by descending priority, so the minimum pops off the end:
+static void bench_sorted_darray_push_pop(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint8_t element[BENCH_MAX_STRIDE];
+    float64_t* priorities;
+    uint8_t* elements = bench_make_elements(stride, count, &priorities);
+    void* array = _darray_create(DARRAY_DEFAULT_CAPACITY, stride);
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        float64_t priority = priorities[i];
+
+        uint64_t low = 0;
+        uint64_t high = darray_length(array);
+        while (low < high)
+        {
+            uint64_t mid = (low + high) / 2;
+            if (bench_element_priority((uint8_t*)array + (mid * stride)) > priority)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+
+        if (low == darray_length(array))
+        {
+            _darray_push(&array, elements + (i * stride));
+        }
+        else
+        {
+            _darray_insert_at(&array, low, elements + (i * stride));
+        }
+    }
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _darray_pop(&array, element);
+    }
+    bench_end(&timer, count * 2, out_sample);
+
+    _darray_destroy(array);
+    bench_free_elements(elements, priorities, stride, count);
+}
+
+static void bench_priority_queue_update(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint8_t element[BENCH_MAX_STRIDE];
+    priority_queue queue;
+    _priority_queue_create(stride, PRIORITY_QUEUE_DEFAULT_ARITY, count, &queue);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        float64_t priority = bench_make_element(element, stride);
+        _priority_queue_push(&queue, element, priority);
+    }
+    // Handles are dense while nothing has been popped:
+    uint64_t* handles = bench_make_randoms(count, count);
+    uint64_t* priorities = bench_make_randoms(count, 1000000);
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        _priority_queue_update(&queue, (priority_queue_handle)handles[i], (float64_t)priorities[i]);
+    }
+    bench_end(&timer, count, out_sample);
+
+    _priority_queue_destroy(&queue);
+    ffree(handles, sizeof(uint64_t) * count, MEMORY_TAG_ARRAY);
+    ffree(priorities, sizeof(uint64_t) * count, MEMORY_TAG_ARRAY);
+}
+
+// -- LRU cache --
+
+// Element layout: lru_node followed by stride bytes of payload.
+static uint8_t* bench_lru_create_elements(uint64_t stride, uint64_t count, uint64_t* out_element_size)
+{
+    *out_element_size = sizeof(lru_node) + stride;
+    return fallocate(*out_element_size * count, MEMORY_TAG_ARRAY);
+}
+
+static void bench_lru_cache_find(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint64_t element_size;
+    uint8_t* elements = bench_lru_create_elements(stride, count, &element_size);
+    lru_cache cache;
+    lru_cache_create((uint32_t)count, 0, MEMORY_TAG_ARRAY, 0, 0, &cache);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        lru_cache_insert(&cache, (lru_node*)(elements + (i * element_size)), i, stride);
+    }
+    uint64_t* keys = bench_make_randoms(count, count);
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        lru_cache_find(&cache, keys[i]);
+    }
+    bench_end(&timer, count, out_sample);
+
+    lru_cache_destroy(&cache);
+    ffree(elements, element_size * count, MEMORY_TAG_ARRAY);
+    ffree(keys, sizeof(uint64_t) * count, MEMORY_TAG_ARRAY);
+}
+
+static void bench_lru_cache_insert_evict(uint64_t stride, uint64_t count, bench_sample* out_sample)
+{
+    uint64_t element_size;
+    uint8_t* elements = bench_lru_create_elements(stride, count, &element_size);
+    lru_cache cache;
+    // Half the elements fit, so the second half of the inserts evict:
+    lru_cache_create((uint32_t)count, (count / 2) * stride, MEMORY_TAG_ARRAY, 0, 0, &cache);
+
+    bench_timer timer;
+    bench_begin(&timer);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        lru_cache_insert(&cache, (lru_node*)(elements + (i * element_size)), i, stride);
+    }
+    bench_end(&timer, count, out_sample);
+
+    lru_cache_destroy(&cache);
+    ffree(elements, element_size * count, MEMORY_TAG_ARRAY);
+}
+
+static const bench_case bench_cases[] = {
+    {"darray_push", bench_darray_push},
+    {"darray_pop", bench_darray_pop},
+    {"darray_insert_at", bench_darray_insert_at},
+    {"darray_pop_at", bench_darray_pop_at},
+    {"priority_queue_push_pop", bench_priority_queue_push_pop},
+    {"sorted_darray_push_pop", bench_sorted_darray_push_pop},
+    {"priority_queue_update", bench_priority_queue_update},
+    {"lru_cache_find", bench_lru_cache_find},
+    {"lru_cache_insert_evict", bench_lru_cache_insert_evict},
+};
+
+static void sort_float64(float64_t* values, uint32_t count)
+{
+    for (uint32_t i = 1; i < count; ++i)
+    {
+        float64_t value = values[i];
+        uint32_t j = i;
+        while (j > 0 && values[j - 1] > value)
+        {
+            values[j] = values[j - 1];
+            --j;
+        }
+        values[j] = value;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool8_t json = FALSE;
+    bool8_t quick = FALSE;
+    uint32_t repetitions = BENCH_DEFAULT_REPETITIONS;
+    const char* filter = 0;
+
+    for (int32_t i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+        {
+            json = TRUE;
+        }
+        else if (strcmp(argv[i], "--quick") == 0)
+        {
+            quick = TRUE;
+        }
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+        {
+            uint32_t value = 0;
+            sscanf(argv[++i], "%u", &value);
+            repetitions = value < 1 ? 1 : (value > BENCH_MAX_REPETITIONS ? BENCH_MAX_REPETITIONS : value);
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [--json] [--quick] [--reps N] [--filter substring]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    initialize_memory();
+
+    uint32_t count_count = quick ? 2 : sizeof(bench_counts) / sizeof(bench_counts[0]);
+    uint32_t stride_count = sizeof(bench_strides) / sizeof(bench_strides[0]);
+    uint32_t case_count = sizeof(bench_cases) / sizeof(bench_cases[0]);
+    bool8_t first_result = TRUE;
+
+    if (json)
+    {
+        printf("{\n  \"repetitions\": %u,\n  \"results\": [", repetitions);
+    }
+    else
+    {
+        printf("%-26s %6s %7s %12s %12s %10s %12s\n", "benchmark", "stride", "count", "median ns/op", "p99 ns/op",
+            "allocs/op", "bytes/op");
+    }
+
+    for (uint32_t c = 0; c < case_count; ++c)
+    {
+        if (filter && !strstr(bench_cases[c].name, filter))
+        {
+            continue;
+        }
+
+        for (uint32_t s = 0; s < stride_count; ++s)
+        {
+            for (uint32_t n = 0; n < count_count; ++n)
+            {
+                uint64_t stride = bench_strides[s];
+                uint64_t count = bench_counts[n];
+
+                // One untimed warm-up run:
+                bench_sample sample;
+                bench_cases[c].run(stride, count, &sample);
+
+                float64_t ns_per_op[BENCH_MAX_REPETITIONS];
+                for (uint32_t r = 0; r < repetitions; ++r)
+                {
+                    bench_cases[c].run(stride, count, &sample);
+                    ns_per_op[r] = (sample.seconds * 1000000000.0) / (float64_t)sample.ops;
+                }
+                sort_float64(ns_per_op, repetitions);
+
+                // Memory traffic is deterministic, so the last sample stands for all repetitions:
+                float64_t median = ns_per_op[repetitions / 2];
+                float64_t p99 = ns_per_op[((repetitions * 99) + 99) / 100 - 1];
+                float64_t allocations = (float64_t)sample.delta.allocation_count / (float64_t)sample.ops;
+                float64_t bytes = (float64_t)(sample.delta.bytes_allocated + sample.delta.bytes_copied +
+                    sample.delta.bytes_set) / (float64_t)sample.ops;
+
+                if (json)
+                {
+                    printf("%s\n    {\"name\": \"%s\", \"stride\": %llu, \"count\": %llu, \"median_ns_per_op\": %.3f, "
+                        "\"p99_ns_per_op\": %.3f, \"allocations_per_op\": %.6f, \"bytes_touched_per_op\": %.3f}",
+                        first_result ? "" : ",", bench_cases[c].name, stride, count, median, p99, allocations, bytes);
+                    first_result = FALSE;
+                }
+                else
+                {
+                    printf("%-26s %6llu %7llu %12.2f %12.2f %10.4f %12.1f\n", bench_cases[c].name, stride, count,
+                        median, p99, allocations, bytes);
+                }
+            }
+        }
+    }
+
+    if (json)
+    {
+        printf("\n  ]\n}\n");
+    }
+
+    shutdown_memory();
+    return 0;
+}
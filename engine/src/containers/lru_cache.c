@@ -0,0 +1,276 @@
+#include "lru_cache.h"
+
+#include "core/logger.h"
+
+// Keeps the index at most half full so linear probe runs stay short:
+#define LRU_INDEX_LOAD_FACTOR 2
+
+static uint64_t lru_hash_key(uint64_t key)
+{
+    // splitmix64 finalizer:
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    return key;
+}
+
+static uint32_t lru_index_find_slot(const lru_cache* cache, uint64_t key)
+{
+    uint32_t mask = cache->index_capacity - 1;
+    uint32_t slot = (uint32_t)lru_hash_key(key) & mask;
+    while (cache->index[slot] && cache->index[slot]->key != key)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Removes the entry at slot, shifting back the rest of its probe run so no tombstones are needed:
+static void lru_index_erase(lru_cache* cache, uint32_t slot)
+{
+    uint32_t mask = cache->index_capacity - 1;
+    uint32_t hole = slot;
+    uint32_t next = (slot + 1) & mask;
+
+    while (cache->index[next])
+    {
+        uint32_t home = (uint32_t)lru_hash_key(cache->index[next]->key) & mask;
+
+        // Move the entry into the hole if its home slot does not lie cyclically in (hole, next]:
+        bool8_t movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable)
+        {
+            cache->index[hole] = cache->index[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+
+    cache->index[hole] = 0;
+}
+
+static void lru_list_unlink(lru_cache* cache, lru_node* node)
+{
+    if (node->prev)
+    {
+        node->prev->next = node->next;
+    }
+    else
+    {
+        cache->head = node->next;
+    }
+
+    if (node->next)
+    {
+        node->next->prev = node->prev;
+    }
+    else
+    {
+        cache->tail = node->prev;
+    }
+
+    node->prev = 0;
+    node->next = 0;
+}
+
+static void lru_list_push_front(lru_cache* cache, lru_node* node)
+{
+    node->prev = 0;
+    node->next = cache->head;
+    if (cache->head)
+    {
+        cache->head->prev = node;
+    }
+    cache->head = node;
+
+    if (!cache->tail)
+    {
+        cache->tail = node;
+    }
+}
+
+// Evicts the least recently used node, unless it is the one to keep:
+static uint64_t lru_cache_evict_tail(lru_cache* cache, const lru_node* keep)
+{
+    lru_node* victim = cache->tail;
+    if (!victim || victim == keep)
+    {
+        return 0;
+    }
+
+    uint64_t weight = victim->weight;
+    lru_cache_remove(cache, victim);
+    if (cache->on_evict)
+    {
+        cache->on_evict(victim, cache->listener);
+    }
+    return weight;
+}
+
+static void lru_cache_trim_keeping(lru_cache* cache, const lru_node* keep)
+{
+    uint64_t capacity = lru_cache_capacity(cache);
+    if (capacity == 0)
+    {
+        return;
+    }
+
+    while (cache->weight > capacity)
+    {
+        if (lru_cache_evict_tail(cache, keep) == 0 && (cache->tail == keep || !cache->tail))
+        {
+            break;
+        }
+    }
+}
+
+void lru_cache_create(uint32_t max_entries, uint64_t capacity, memory_tag budget_tag,
+    ptrfn_on_lru_evict on_evict, void* listener, lru_cache* out_cache)
+{
+    fzero_memory(out_cache, sizeof(lru_cache));
+
+    uint32_t index_capacity = 1;
+    while (index_capacity < max_entries * LRU_INDEX_LOAD_FACTOR)
+    {
+        index_capacity <<= 1;
+    }
+
+    out_cache->max_entries = max_entries;
+    out_cache->index_capacity = index_capacity;
+    out_cache->index = fallocate(sizeof(lru_node*) * index_capacity, MEMORY_TAG_DICT);
+    out_cache->capacity = capacity;
+    out_cache->budget_tag = budget_tag;
+    out_cache->on_evict = on_evict;
+    out_cache->listener = listener;
+}
+
+void lru_cache_destroy(lru_cache* cache)
+{
+    if (cache->index)
+    {
+        ffree(cache->index, sizeof(lru_node*) * cache->index_capacity, MEMORY_TAG_DICT);
+    }
+    fzero_memory(cache, sizeof(lru_cache));
+}
+
+void lru_cache_clear(lru_cache* cache)
+{
+    while (cache->tail)
+    {
+        lru_cache_evict_tail(cache, 0);
+    }
+}
+
+bool8_t lru_cache_insert(lru_cache* cache, lru_node* node, uint64_t key, uint64_t weight)
+{
+    // Checked first, so a duplicate never evicts an unrelated entry:
+    uint32_t slot = lru_index_find_slot(cache, key);
+    if (cache->index[slot])
+    {
+        FWARN("LRU cache already contains key %llu.", key);
+        return FALSE;
+    }
+
+    if (cache->count >= cache->max_entries)
+    {
+        // Make room by entry count before giving up:
+        if (lru_cache_evict_tail(cache, 0) == 0 && cache->count >= cache->max_entries)
+        {
+            FERROR("LRU cache index is full! Max entries: %u", cache->max_entries);
+            return FALSE;
+        }
+        // Removing from the index can move entries between slots:
+        slot = lru_index_find_slot(cache, key);
+    }
+
+    node->key = key;
+    node->weight = weight;
+    cache->index[slot] = node;
+    lru_list_push_front(cache, node);
+    cache->count++;
+    cache->weight += weight;
+
+    lru_cache_trim_keeping(cache, node);
+    return TRUE;
+}
+
+lru_node* lru_cache_find(lru_cache* cache, uint64_t key)
+{
+    lru_node* node = lru_cache_peek(cache, key);
+    if (node)
+    {
+        lru_cache_touch(cache, node);
+    }
+    return node;
+}
+
+lru_node* lru_cache_peek(const lru_cache* cache, uint64_t key)
+{
+    return cache->index[lru_index_find_slot(cache, key)];
+}
+
+void lru_cache_touch(lru_cache* cache, lru_node* node)
+{
+    if (cache->head == node)
+    {
+        return;
+    }
+
+    lru_list_unlink(cache, node);
+    lru_list_push_front(cache, node);
+}
+
+void lru_cache_remove(lru_cache* cache, lru_node* node)
+{
+    uint32_t slot = lru_index_find_slot(cache, node->key);
+    if (cache->index[slot] != node)
+    {
+        FWARN("lru_cache_remove called with a node that is not cached.");
+        return;
+    }
+
+    lru_index_erase(cache, slot);
+    lru_list_unlink(cache, node);
+    cache->count--;
+    cache->weight -= node->weight;
+}
+
+void lru_cache_set_weight(lru_cache* cache, lru_node* node, uint64_t weight)
+{
+    // A node that isn't cached only carries its weight along until it is inserted:
+    if (cache->index[lru_index_find_slot(cache, node->key)] != node)
+    {
+        node->weight = weight;
+        return;
+    }
+
+    cache->weight = cache->weight - node->weight + weight;
+    node->weight = weight;
+    lru_cache_trim_keeping(cache, node);
+}
+
+uint64_t lru_cache_evict(lru_cache* cache, uint64_t bytes)
+{
+    uint64_t released = 0;
+    while (released < bytes && cache->tail)
+    {
+        released += lru_cache_evict_tail(cache, 0);
+    }
+    return released;
+}
+
+void lru_cache_trim(lru_cache* cache)
+{
+    lru_cache_trim_keeping(cache, 0);
+}
+
+uint64_t lru_cache_capacity(const lru_cache* cache)
+{
+    if (cache->capacity)
+    {
+        return cache->capacity;
+    }
+    return get_memory_tag_budget(cache->budget_tag);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "defines.h"
+#include "core/fmemory.h"
+
+/*
+ * Intrusive LRU cache.
+ *
+ * The cache never allocates per entry: owners embed an lru_node in their own struct (texture, pipeline,
+ * decompressed asset...) and hand it to the cache. Recency is kept in a doubly-linked list threaded through
+ * those nodes, and lookups go through a fixed-size open-addressing index of node pointers allocated once
+ * at creation. Touch, insert, remove and evict are all O(1).
+ *
+ * Capacity is measured in bytes (the sum of node weights). If no explicit capacity is given, the budget
+ * of the cache's memory tag is used (see set_memory_tag_budget), and it is re-read on every insert so
+ * budgets can be tuned at runtime.
+ */
+
+typedef struct lru_node
+{
+    struct lru_node* prev;
+    struct lru_node* next;
+    uint64_t key;
+    uint64_t weight;
+} lru_node;
+
+// Invoked for every entry the cache evicts. The owner should release the resource the node is embedded in:
+typedef void (*ptrfn_on_lru_evict)(lru_node* node, void* listener);
+
+typedef struct lru_cache
+{
+    // Most recently used:
+    lru_node* head;
+    // Least recently used, next to be evicted:
+    lru_node* tail;
+
+    lru_node** index;
+    uint32_t index_capacity;
+    uint32_t max_entries;
+    uint32_t count;
+
+    uint64_t weight;
+    uint64_t capacity;
+    memory_tag budget_tag;
+
+    ptrfn_on_lru_evict on_evict;
+    void* listener;
+} lru_cache;
+
+// Retrieves the struct an lru_node is embedded in:
+#define LRU_NODE_OWNER(type, member, node_ptr) \
+    ((type*)((uint8_t*)(node_ptr) - __builtin_offsetof(type, member)))
+
+/**
+ * Creates an LRU cache.
+ * @param max_entries The maximum number of entries the index can hold.
+ * @param capacity The byte capacity. If 0, the budget of budget_tag is used instead.
+ * @param budget_tag The memory tag whose budget drives the capacity when capacity is 0.
+ * @param on_evict The callback invoked for evicted entries. Can be 0/NULL.
+ * @param listener A pointer passed back to on_evict. Can be 0/NULL.
+ * @param out_cache The cache to initialize.
+ */
+FAPI void lru_cache_create(uint32_t max_entries, uint64_t capacity, memory_tag budget_tag,
+    ptrfn_on_lru_evict on_evict, void* listener, lru_cache* out_cache);
+
+// Frees the index. Entries are not evicted; call lru_cache_clear first if the owners need to be notified.
+FAPI void lru_cache_destroy(lru_cache* cache);
+
+// Evicts every entry, invoking on_evict for each one.
+FAPI void lru_cache_clear(lru_cache* cache);
+
+/**
+ * Inserts a node as the most recently used entry, then evicts least recently used entries until the cache
+ * is within capacity. The inserted node itself is never evicted by its own insertion.
+ * @returns TRUE if inserted; FALSE if the key already exists or the index is full.
+ */
+FAPI bool8_t lru_cache_insert(lru_cache* cache, lru_node* node, uint64_t key, uint64_t weight);
+
+// Looks up a key and marks it as most recently used. Returns 0 if not found.
+FAPI lru_node* lru_cache_find(lru_cache* cache, uint64_t key);
+
+// Looks up a key without affecting recency. Returns 0 if not found.
+FAPI lru_node* lru_cache_peek(const lru_cache* cache, uint64_t key);
+
+// Marks an already cached node as most recently used.
+FAPI void lru_cache_touch(lru_cache* cache, lru_node* node);
+
+// Removes a node without invoking on_evict.
+FAPI void lru_cache_remove(lru_cache* cache, lru_node* node);
+
+// Changes the weight of a cached node (e.g. once its data is decompressed), then trims to capacity. For a node that
+// is not cached, only its weight changes.
+FAPI void lru_cache_set_weight(lru_cache* cache, lru_node* node, uint64_t weight);
+
+/**
+ * Evicts least recently used entries until at least the requested amount of bytes has been released.
+ * @returns The number of bytes actually released.
+ */
+FAPI uint64_t lru_cache_evict(lru_cache* cache, uint64_t bytes);
+
+// Evicts least recently used entries until the cache is within its current capacity.
+FAPI void lru_cache_trim(lru_cache* cache);
+
+// Returns the capacity in effect, in bytes. 0 means unbounded.
+FAPI uint64_t lru_cache_capacity(const lru_cache* cache);
@@ -0,0 +1,316 @@
+#include "priority_queue.h"
+
+#include "core/fmemory.h"
+#include "core/logger.h"
+
+// Marks an entry in positions as part of the free handle list rather than a heap index:
+#define PRIORITY_QUEUE_FREE_BIT 0x80000000u
+
+// Size of the positions region, padded so the payloads after it stay 16-byte aligned for any capacity:
+static uint64_t priority_queue_positions_size(uint32_t capacity)
+{
+    return ((uint64_t)capacity * sizeof(uint32_t) + 15) & ~(uint64_t)15;
+}
+
+static uint64_t priority_queue_block_size(uint32_t capacity, uint64_t stride)
+{
+    return capacity * (sizeof(priority_queue_node) + stride) + priority_queue_positions_size(capacity);
+}
+
+static void priority_queue_assign_block(priority_queue* queue, void* block)
+{
+    queue->nodes = (priority_queue_node*)block;
+    queue->positions = (uint32_t*)(queue->nodes + queue->capacity);
+    queue->payloads = (void*)((uint8_t*)queue->positions + priority_queue_positions_size(queue->capacity));
+}
+
+// Chains handles [first, capacity) onto the front of the free list:
+static void priority_queue_link_free_handles(priority_queue* queue, uint32_t first)
+{
+    for (uint32_t i = first; i < queue->capacity; ++i)
+    {
+        uint32_t next = (i + 1 < queue->capacity) ? (i + 1) : queue->free_head;
+        queue->positions[i] = next | PRIORITY_QUEUE_FREE_BIT;
+    }
+    queue->free_head = first;
+}
+
+static bool8_t priority_queue_is_queued(const priority_queue* queue, priority_queue_handle handle)
+{
+    return handle < queue->capacity && (queue->positions[handle] & PRIORITY_QUEUE_FREE_BIT) == 0;
+}
+
+static void* priority_queue_payload(const priority_queue* queue, priority_queue_handle handle)
+{
+    return (void*)((uint64_t)queue->payloads + (handle * queue->stride));
+}
+
+static void priority_queue_release_handle(priority_queue* queue, priority_queue_handle handle)
+{
+    queue->positions[handle] = queue->free_head | PRIORITY_QUEUE_FREE_BIT;
+    queue->free_head = handle;
+}
+
+static void priority_queue_resize(priority_queue* queue)
+{
+    uint32_t old_capacity = queue->capacity;
+    uint32_t new_capacity = old_capacity * PRIORITY_QUEUE_RESIZE_FACTOR;
+    if (new_capacity >= PRIORITY_QUEUE_FREE_BIT)
+    {
+        FFATAL("Priority queue capacity exceeded the maximum handle count.");
+        return;
+    }
+
+    void* old_block = queue->nodes;
+    void* new_block = fallocate(priority_queue_block_size(new_capacity, queue->stride), MEMORY_TAG_PRIORITY_QUEUE);
+
+    priority_queue old_view = *queue;
+    queue->capacity = new_capacity;
+    priority_queue_assign_block(queue, new_block);
+
+    fcopy_memory(queue->nodes, old_view.nodes, queue->length * sizeof(priority_queue_node));
+    fcopy_memory(queue->positions, old_view.positions, old_capacity * sizeof(uint32_t));
+    fcopy_memory(queue->payloads, old_view.payloads, old_capacity * queue->stride);
+
+    // The queue is full when it grows, so the free list is empty and the new handles make up all of it:
+    queue->free_head = INVALID_PRIORITY_QUEUE_HANDLE;
+    priority_queue_link_free_handles(queue, old_capacity);
+
+    ffree(old_block, priority_queue_block_size(old_capacity, queue->stride), MEMORY_TAG_PRIORITY_QUEUE);
+}
+
+static void priority_queue_sift_up(priority_queue* queue, uint32_t index)
+{
+    priority_queue_node node = queue->nodes[index];
+    while (index > 0)
+    {
+        uint32_t parent = (index - 1) / queue->arity;
+        if (queue->nodes[parent].priority <= node.priority)
+        {
+            break;
+        }
+
+        queue->nodes[index] = queue->nodes[parent];
+        queue->positions[queue->nodes[index].handle] = index;
+        index = parent;
+    }
+
+    queue->nodes[index] = node;
+    queue->positions[node.handle] = index;
+}
+
+static void priority_queue_sift_down(priority_queue* queue, uint32_t index)
+{
+    priority_queue_node node = queue->nodes[index];
+    uint32_t length = queue->length;
+    uint32_t arity = queue->arity;
+
+    for (;;)
+    {
+        uint64_t first_child = ((uint64_t)index * arity) + 1;
+        if (first_child >= length)
+        {
+            break;
+        }
+
+        // Children of a node are adjacent, so finding the smallest is a scan over one or two cache lines:
+        uint32_t last_child = (first_child + arity < length) ? (uint32_t)(first_child + arity) : length;
+        uint32_t best = (uint32_t)first_child;
+        for (uint32_t c = best + 1; c < last_child; ++c)
+        {
+            if (queue->nodes[c].priority < queue->nodes[best].priority)
+            {
+                best = c;
+            }
+        }
+
+        if (queue->nodes[best].priority >= node.priority)
+        {
+            break;
+        }
+
+        queue->nodes[index] = queue->nodes[best];
+        queue->positions[queue->nodes[index].handle] = index;
+        index = best;
+    }
+
+    queue->nodes[index] = node;
+    queue->positions[node.handle] = index;
+}
+
+// Removes the node at index, refilling the hole with the last node:
+static void priority_queue_remove_at(priority_queue* queue, uint32_t index)
+{
+    priority_queue_node removed = queue->nodes[index];
+    priority_queue_release_handle(queue, removed.handle);
+
+    queue->length--;
+    if (index == queue->length)
+    {
+        return;
+    }
+
+    queue->nodes[index] = queue->nodes[queue->length];
+    queue->positions[queue->nodes[index].handle] = index;
+    if (queue->nodes[index].priority < removed.priority)
+    {
+        priority_queue_sift_up(queue, index);
+    }
+    else
+    {
+        priority_queue_sift_down(queue, index);
+    }
+}
+
+void _priority_queue_create(uint64_t stride, uint32_t arity, uint32_t capacity, priority_queue* out_queue)
+{
+    if (arity < 2)
+    {
+        FWARN("Priority queue arity must be at least 2, got %u. Using 2.", arity);
+        arity = 2;
+    }
+
+    if (capacity == 0)
+    {
+        capacity = 1;
+    }
+
+    fzero_memory(out_queue, sizeof(priority_queue));
+    out_queue->stride = stride;
+    out_queue->arity = arity;
+    out_queue->capacity = capacity;
+    out_queue->free_head = INVALID_PRIORITY_QUEUE_HANDLE;
+
+    void* block = fallocate(priority_queue_block_size(capacity, stride), MEMORY_TAG_PRIORITY_QUEUE);
+    priority_queue_assign_block(out_queue, block);
+    priority_queue_link_free_handles(out_queue, 0);
+}
+
+void _priority_queue_destroy(priority_queue* queue)
+{
+    if (queue->nodes)
+    {
+        ffree(queue->nodes, priority_queue_block_size(queue->capacity, queue->stride), MEMORY_TAG_PRIORITY_QUEUE);
+    }
+    fzero_memory(queue, sizeof(priority_queue));
+}
+
+void _priority_queue_clear(priority_queue* queue)
+{
+    queue->length = 0;
+    queue->free_head = INVALID_PRIORITY_QUEUE_HANDLE;
+    priority_queue_link_free_handles(queue, 0);
+}
+
+priority_queue_handle _priority_queue_push(priority_queue* queue, const void* value_ptr, float64_t priority)
+{
+    if (queue->free_head == INVALID_PRIORITY_QUEUE_HANDLE)
+    {
+        priority_queue_resize(queue);
+        if (queue->free_head == INVALID_PRIORITY_QUEUE_HANDLE)
+        {
+            return INVALID_PRIORITY_QUEUE_HANDLE;
+        }
+    }
+
+    priority_queue_handle handle = queue->free_head;
+    uint32_t next = queue->positions[handle];
+    queue->free_head = (next == INVALID_PRIORITY_QUEUE_HANDLE) ? next : (next & ~PRIORITY_QUEUE_FREE_BIT);
+
+    fcopy_memory(priority_queue_payload(queue, handle), value_ptr, queue->stride);
+
+    uint32_t index = queue->length++;
+    queue->nodes[index].priority = priority;
+    queue->nodes[index].handle = handle;
+    queue->nodes[index].padding = 0;
+    priority_queue_sift_up(queue, index);
+    return handle;
+}
+
+bool8_t _priority_queue_pop(priority_queue* queue, void* dest, float64_t* out_priority)
+{
+    if (queue->length == 0)
+    {
+        return FALSE;
+    }
+
+    priority_queue_node top = queue->nodes[0];
+    if (dest)
+    {
+        fcopy_memory(dest, priority_queue_payload(queue, top.handle), queue->stride);
+    }
+    if (out_priority)
+    {
+        *out_priority = top.priority;
+    }
+
+    priority_queue_remove_at(queue, 0);
+    return TRUE;
+}
+
+bool8_t _priority_queue_peek(const priority_queue* queue, void* dest, float64_t* out_priority)
+{
+    if (queue->length == 0)
+    {
+        return FALSE;
+    }
+
+    if (dest)
+    {
+        fcopy_memory(dest, priority_queue_payload(queue, queue->nodes[0].handle), queue->stride);
+    }
+    if (out_priority)
+    {
+        *out_priority = queue->nodes[0].priority;
+    }
+    return TRUE;
+}
+
+bool8_t _priority_queue_update(priority_queue* queue, priority_queue_handle handle, float64_t priority)
+{
+    if (!priority_queue_is_queued(queue, handle))
+    {
+        FERROR("Priority queue handle is not queued! Handle: %u", handle);
+        return FALSE;
+    }
+
+    uint32_t index = queue->positions[handle];
+    float64_t old_priority = queue->nodes[index].priority;
+    queue->nodes[index].priority = priority;
+
+    if (priority < old_priority)
+    {
+        priority_queue_sift_up(queue, index);
+    }
+    else if (priority > old_priority)
+    {
+        priority_queue_sift_down(queue, index);
+    }
+    return TRUE;
+}
+
+bool8_t _priority_queue_remove(priority_queue* queue, priority_queue_handle handle, void* dest)
+{
+    if (!priority_queue_is_queued(queue, handle))
+    {
+        FERROR("Priority queue handle is not queued! Handle: %u", handle);
+        return FALSE;
+    }
+
+    if (dest)
+    {
+        fcopy_memory(dest, priority_queue_payload(queue, handle), queue->stride);
+    }
+
+    priority_queue_remove_at(queue, queue->positions[handle]);
+    return TRUE;
+}
+
+void* _priority_queue_get(const priority_queue* queue, priority_queue_handle handle)
+{
+    if (!priority_queue_is_queued(queue, handle))
+    {
+        return 0;
+    }
+    return priority_queue_payload(queue, handle);
+}
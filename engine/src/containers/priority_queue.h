@@ -0,0 +1,118 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ * d-ary min-heap priority queue (lowest priority value is popped first).
+ *
+ * Memory layout (single contiguous block):
+ * priority_queue_node nodes[capacity]   - the heap itself; only these 16-byte nodes move when sifting.
+ * uint32_t positions[capacity]          - handle -> index in nodes, or the next free handle when unused.
+ *                                         Padded to a multiple of 16 bytes, so payloads stay aligned.
+ * payloads[capacity * stride]           - element data, indexed by handle. Never moves while the element is queued.
+ *
+ * Handles stay valid from push until the element is popped or removed, which is what allows
+ * priority_queue_update (decrease/increase-key) and priority_queue_remove in O(log_d n).
+ */
+
+typedef uint32_t priority_queue_handle;
+
+#define INVALID_PRIORITY_QUEUE_HANDLE 0xFFFFFFFFu
+
+typedef struct priority_queue_node
+{
+    float64_t priority;
+    priority_queue_handle handle;
+    uint32_t padding;
+} priority_queue_node;
+
+typedef struct priority_queue
+{
+    uint64_t stride;
+    uint32_t arity;
+    uint32_t length;
+    uint32_t capacity;
+    uint32_t free_head;
+
+    priority_queue_node* nodes;
+    uint32_t* positions;
+    void* payloads;
+} priority_queue;
+
+// -- Low-level internal functions --
+FAPI void _priority_queue_create(uint64_t stride, uint32_t arity, uint32_t capacity, priority_queue* out_queue);
+FAPI void _priority_queue_destroy(priority_queue* queue);
+FAPI void _priority_queue_clear(priority_queue* queue);
+
+FAPI priority_queue_handle _priority_queue_push(priority_queue* queue, const void* value_ptr, float64_t priority);
+
+/**
+ * Pops the element with the lowest priority value.
+ * @param queue The queue to pop from.
+ * @param dest Where to copy the element to. Can be 0/NULL.
+ * @param out_priority Where to write the element's priority to. Can be 0/NULL.
+ * @returns TRUE if an element was popped; FALSE if the queue was empty.
+ */
+FAPI bool8_t _priority_queue_pop(priority_queue* queue, void* dest, float64_t* out_priority);
+
+/**
+ * Copies the element with the lowest priority value without removing it.
+ * @returns TRUE if the queue was not empty; otherwise FALSE.
+ */
+FAPI bool8_t _priority_queue_peek(const priority_queue* queue, void* dest, float64_t* out_priority);
+
+/**
+ * Changes the priority of a queued element. Works in both directions (decrease-key and increase-key).
+ * @returns TRUE on success; FALSE if the handle is not currently queued.
+ */
+FAPI bool8_t _priority_queue_update(priority_queue* queue, priority_queue_handle handle, float64_t priority);
+
+/**
+ * Removes a queued element by handle, optionally copying it out first.
+ * @returns TRUE on success; FALSE if the handle is not currently queued.
+ */
+FAPI bool8_t _priority_queue_remove(priority_queue* queue, priority_queue_handle handle, void* dest);
+
+// Returns a pointer to the payload of a queued element, or 0 if the handle is not queued.
+// The pointer is invalidated by the next push that grows the queue.
+FAPI void* _priority_queue_get(const priority_queue* queue, priority_queue_handle handle);
+
+#define PRIORITY_QUEUE_DEFAULT_ARITY 4
+#define PRIORITY_QUEUE_DEFAULT_CAPACITY 16
+#define PRIORITY_QUEUE_RESIZE_FACTOR 2
+
+#define priority_queue_create(type, out_queue) \
+    _priority_queue_create(sizeof(type), PRIORITY_QUEUE_DEFAULT_ARITY, PRIORITY_QUEUE_DEFAULT_CAPACITY, out_queue)
+
+#define priority_queue_reserve(type, arity, capacity, out_queue) \
+    _priority_queue_create(sizeof(type), arity, capacity, out_queue)
+
+#define priority_queue_destroy(queue) _priority_queue_destroy(queue)
+
+// out_handle may be 0/NULL if the handle is not needed:
+#define priority_queue_push(queue, value, priority, out_handle)                       \
+do {                                                                                  \
+    typeof(value) temp = value;                                                       \
+    priority_queue_handle temp_handle = _priority_queue_push(queue, &temp, priority); \
+    priority_queue_handle* temp_out = (out_handle);                                   \
+    if (temp_out) { *temp_out = temp_handle; }                                        \
+} while (0)
+
+#define priority_queue_pop(queue, value_ptr, priority_ptr)                      \
+    _priority_queue_pop(queue, value_ptr, priority_ptr)
+
+#define priority_queue_peek(queue, value_ptr, priority_ptr)                     \
+    _priority_queue_peek(queue, value_ptr, priority_ptr)
+
+#define priority_queue_update(queue, handle, priority)                          \
+    _priority_queue_update(queue, handle, priority)
+
+#define priority_queue_remove(queue, handle, value_ptr)                         \
+    _priority_queue_remove(queue, handle, value_ptr)
+
+#define priority_queue_get(type, queue, handle)                                 \
+    ((type*)_priority_queue_get(queue, handle))
+
+#define priority_queue_length(queue) ((queue)->length)
+
+#define priority_queue_clear(queue) _priority_queue_clear(queue)
@@ -2,8 +2,13 @@
 
 #include "fmemory.h"
 #include "core/clock.h"
+#include "core/frame_limiter.h"
+#include "core/frame_stats.h"
+#include "core/profiler.h"
+#include "core/fstring.h"
 #include "core/event.h"
 #include "core/input.h"
+#include "core/input_actions.h"
 
 #include "game_types.h"
 
@@ -18,6 +23,12 @@ typedef struct application_state
     game* game_instance;
     platform_state platform;
     float64_t last_time;
+    // Fixed timestep, 0 if the game is updated once per frame:
+    float64_t tick_seconds;
+    uint16_t max_ticks_per_frame;
+    // Simulation time not consumed by a tick yet:
+    float64_t tick_accumulator;
+    frame_limiter limiter;
     int16_t width;
     int16_t height;
     bool8_t is_running;
@@ -43,7 +54,11 @@ bool8_t application_create(game* game_instance)
 
     // Initialize Subsystems:
     initialize_logging();
+    profiler_initialize();
+    profiler_set_thread_name("main");
+    string_interner_initialize();
     input_initialize();
+    input_actions_initialize();
 
     // TODO: Remove this
     FFATAL("A test message: %f", 3.14f);
@@ -56,6 +71,19 @@ bool8_t application_create(game* game_instance)
     app_state.is_running = TRUE;
     app_state.is_suspended = FALSE;
 
+    app_state.tick_seconds = game_instance->app_config.tick_rate > 0 ? 1.0 / game_instance->app_config.tick_rate : 0;
+    app_state.max_ticks_per_frame = game_instance->app_config.max_ticks_per_frame ?
+        game_instance->app_config.max_ticks_per_frame : APPLICATION_DEFAULT_MAX_TICKS_PER_FRAME;
+    app_state.tick_accumulator = 0;
+    frame_limiter_create(game_instance->app_config.target_frame_rate, &app_state.limiter);
+
+    frame_stats_initialize();
+    const char* frame_stats_path = platform_get_environment_variable("FOO_FRAME_STATS_CSV");
+    if (frame_stats_path)
+    {
+        frame_stats_set_csv_path(frame_stats_path);
+    }
+
     if (!event_initialize())
     {
         FERROR("Event system failed initialization. Application can't continue");
@@ -66,6 +94,19 @@ bool8_t application_create(game* game_instance)
     event_register(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_register(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
 
+    // Reproducible runs for benchmarking, see input_recording_start/input_replay_start:
+    const char* record_path = platform_get_environment_variable("FOO_INPUT_RECORD");
+    if (record_path)
+    {
+        input_recording_start(record_path);
+    }
+
+    const char* replay_path = platform_get_environment_variable("FOO_INPUT_REPLAY");
+    if (replay_path && !input_replay_start(replay_path, TRUE))
+    {
+        FERROR("Input replay could not be started, running with live input.");
+    }
+
     if (!platform_startup(
         &app_state.platform,
         game_instance->app_config.name,
@@ -97,24 +138,113 @@ bool8_t application_create(game* game_instance)
     return TRUE;
 }
 
+/**
+ * Runs the game's update for a frame: once with the frame's delta, or as many fixed ticks as the accumulated time
+ * allows, capped at max_ticks_per_frame so a slow frame can't snowball into ever more ticks.
+ * @param out_ticks The amount of updates run.
+ * @param out_alpha The fraction of a tick left in the accumulator, for render interpolation.
+ * @returns FALSE if the game's update failed.
+ */
+static bool8_t application_update_game(float64_t delta, uint32_t* out_ticks, float32_t* out_alpha)
+{
+    game* game_instance = app_state.game_instance;
+    if (app_state.tick_seconds <= 0)
+    {
+        *out_ticks = 1;
+        *out_alpha = 1.0f;
+        if (!game_instance->update(game_instance, (float32_t)delta))
+        {
+            return FALSE;
+        }
+        input_tick();
+        return TRUE;
+    }
+
+    *out_ticks = 0;
+    app_state.tick_accumulator += delta;
+    while (app_state.tick_accumulator >= app_state.tick_seconds)
+    {
+        // A replay feeds input between frames only, so the ticks it was recorded before have to start a frame. What
+        // is held back is capped like any backlog, or slow frames would let it grow without bound:
+        if (*out_ticks > 0 && input_replay_is_due())
+        {
+            float64_t max_backlog = app_state.max_ticks_per_frame * app_state.tick_seconds;
+            if (app_state.tick_accumulator > max_backlog)
+            {
+                FWARN("Simulation fell %.1fms behind during replay, dropping it.",
+                    (app_state.tick_accumulator - max_backlog) * 1000.0);
+                app_state.tick_accumulator = max_backlog;
+            }
+            break;
+        }
+
+        if (*out_ticks == app_state.max_ticks_per_frame)
+        {
+            // Spiral of death guard: drop the backlog but keep the partial tick, so alpha stays continuous:
+            float64_t behind = app_state.tick_accumulator;
+            while (app_state.tick_accumulator >= app_state.tick_seconds)
+            {
+                app_state.tick_accumulator -= app_state.tick_seconds;
+            }
+            FWARN("Simulation fell %.1fms behind, dropping it.", (behind - app_state.tick_accumulator) * 1000.0);
+            break;
+        }
+
+        if (!game_instance->update(game_instance, (float32_t)app_state.tick_seconds))
+        {
+            return FALSE;
+        }
+        app_state.tick_accumulator -= app_state.tick_seconds;
+        (*out_ticks)++;
+        input_tick();
+    }
+
+    // Held back by a replay, more than a tick can be left:
+    float64_t alpha = app_state.tick_accumulator / app_state.tick_seconds;
+    *out_alpha = alpha < 1.0 ? (float32_t)alpha : 1.0f;
+    return TRUE;
+}
+
 bool8_t application_run()
 {
     clock_start(&app_state.clock);
     clock_update(&app_state.clock);
     app_state.last_time = app_state.clock.elapsed;
 
-    float64_t running_time = 0;
-    uint8_t frame_count = 0;
-    float64_t target_frame_seconds = 1.0f / 60.0f;
 
-    FINFO(get_memory_usage_str());
+    char report_buffer[2048];
+    string_builder report;
+    string_builder_create_from_buffer(report_buffer, sizeof(report_buffer), 0, &report);
+    get_memory_usage_report(&report);
+    FINFO("%s", string_builder_cstr(&report));
+    string_builder_destroy(&report);
 
     while (app_state.is_running)
     {
+        PROFILE_ZONE_BEGIN("frame");
+
+        PROFILE_ZONE_BEGIN("pump_messages");
         if (!platform_pump_messages(&app_state.platform))
         {
             app_state.is_running = FALSE;
         }
+        PROFILE_ZONE_END();
+
+        PROFILE_ZONE_BEGIN("input");
+        // While replaying, this frame's recorded input replaces what the platform just delivered:
+        input_replay_update();
+
+        // Actions see this frame's input, and their events go out with the same dispatch:
+        input_actions_update();
+        PROFILE_ZONE_END();
+
+        // Deliver the events posted while pumping messages, by other threads since the last frame and by last
+        // frame's handlers in one batch:
+        PROFILE_ZONE_BEGIN("events");
+        event_collect_threaded();
+        event_dispatch_posted();
+        event_stats_update();
+        PROFILE_ZONE_END();
 
         if (!app_state.is_suspended)
         {
@@ -124,54 +254,73 @@ bool8_t application_run()
             float64_t delta = (current_time - app_state.last_time);
             float64_t frame_start_time = platform_get_absolute_time();
 
-            if (!app_state.game_instance->update(app_state.game_instance, (float32_t) delta))
+            uint32_t ticks;
+            float32_t alpha;
+            PROFILE_ZONE_BEGIN("update");
+            bool8_t updated = application_update_game(delta, &ticks, &alpha);
+            PROFILE_ZONE_END();
+            if (!updated)
             {
                 FFATAL("Game update failed, shutting down.");
                 app_state.is_running = FALSE;
+                // Ends the frame zone:
+                PROFILE_ZONE_END();
                 break;
             }
+            float64_t update_end_time = platform_get_absolute_time();
 
             // Call teh game's render routine:
-            if (!app_state.game_instance->render(app_state.game_instance, (float32_t) delta))
+            PROFILE_ZONE_BEGIN("render");
+            bool8_t rendered = app_state.game_instance->render(app_state.game_instance, (float32_t) delta, alpha);
+            if (rendered)
+            {
+                // TODO: refactor packet creation
+                render_packet packet;
+                packet.delta_time = delta;
+                packet.input_time = input_take_earliest_event_time();
+                renderer_draw_frame(&packet);
+            }
+            PROFILE_ZONE_END();
+            if (!rendered)
             {
                 FFATAL("Game render failed, shutting down.");
                 app_state.is_running = FALSE;
+                // Ends the frame zone:
+                PROFILE_ZONE_END();
                 break;
             }
 
-            // TODO: refactor packet creation
-            render_packet packet;
-            packet.delta_time = delta;
-            renderer_draw_frame(&packet);
-
-            // Figure out how long the frame took:
-            float64_t frame_end_time = platform_get_absolute_time();
-            float64_t frame_elapsed_time = frame_end_time - frame_start_time;
-            running_time += frame_elapsed_time;
-            float64_t remaining_seconds = target_frame_seconds - frame_elapsed_time;
-
-            if (remaining_seconds > 0)
-            {
-                float64_t remaining_ms = (remaining_seconds * 1000);
+            float64_t render_end_time = platform_get_absolute_time();
 
-                // If there is time left, give it back to the OS.
-                bool8_t limit_frames = FALSE;
-                if (remaining_ms > 0 && limit_frames)
-                {
-                    platform_sleep(remaining_ms - 1);
-                }
+            // If there is time left, give it back to the OS:
+            PROFILE_ZONE_BEGIN("frame_limiter");
+            frame_limiter_wait(&app_state.limiter);
+            PROFILE_ZONE_END();
 
-                frame_count++;
-            }
+            // Figure out how long the frame took. The frame itself runs from the previous frame's clock update to
+            // this one's, so it includes pumping messages and dispatching events:
+            float64_t frame_times[FRAME_STAT_MAX];
+            frame_times[FRAME_STAT_FRAME] = delta;
+            frame_times[FRAME_STAT_UPDATE] = update_end_time - frame_start_time;
+            frame_times[FRAME_STAT_RENDER] = render_end_time - update_end_time;
+            frame_times[FRAME_STAT_IDLE] = platform_get_absolute_time() - render_end_time;
+            frame_stats_record(frame_times);
 
             // N.B: Input update/state copying should be always handled
             // after any input should be recorded; e.g., before tihs line.
             // As a safety, input is the last thing to be updated before the frame ends.
-            input_update(delta);
+            // Frames that ran no tick leave it alone, so the next tick still sees keys pressed/released since the
+            // last one:
+            if (ticks > 0)
+            {
+                input_update(delta);
+            }
 
             // Update last time:
             app_state.last_time = current_time;
         }
+
+        PROFILE_ZONE_END();
     }
 
     app_state.is_running = FALSE;
@@ -180,16 +329,41 @@ bool8_t application_run()
     event_unregister(EVENT_CODE_KEY_PRESSED, 0, application_on_key);
     event_unregister(EVENT_CODE_KEY_RELEASED, 0, application_on_key);
 
+    frame_stats_shutdown();
     event_shutdown();
+    input_actions_shutdown();
     input_shutdown();
+    string_interner_shutdown();
 
     renderer_shutdown();
+    frame_limiter_destroy(&app_state.limiter);
 
     platform_shutdown(&app_state.platform);
 
+    // Set to a path to get a Chrome trace of the last frames and the shutdown, see profiler_export_chrome_trace:
+    const char* trace_path = platform_get_environment_variable("FOO_PROFILE_TRACE");
+    if (trace_path)
+    {
+        profiler_export_chrome_trace(trace_path);
+    }
+    profiler_shutdown();
+
+    // Last, so output from the other subsystems' shutdown still reaches the console and log file:
+    shutdown_logging();
+
     return TRUE;
 }
 
+void application_set_target_frame_rate(float32_t target_frame_rate)
+{
+    frame_limiter_set_target(&app_state.limiter, target_frame_rate);
+}
+
+void application_get_frame_jitter(sample_summary* out_summary)
+{
+    frame_limiter_get_jitter(&app_state.limiter, out_summary);
+}
+
 bool8_t application_on_event(uint16_t code, void* sender, void* listener_list, event_context context)
 {
     switch (code)
@@ -3,6 +3,7 @@
 #include "defines.h"
 
 struct game;
+struct sample_summary;
 
 typedef struct application_config
 {
@@ -11,8 +12,26 @@ typedef struct application_config
     int16_t start_width;
     int16_t start_height;
 
+    // Simulation ticks per second. The game is updated in fixed steps of 1 / tick_rate and renders with the fraction
+    // of a step left over; 0 updates once per frame with the frame's delta time instead:
+    float32_t tick_rate;
+    // Upper bound on ticks run in one frame, after which simulation time the game fell behind is dropped. 0 means
+    // APPLICATION_DEFAULT_MAX_TICKS_PER_FRAME:
+    uint16_t max_ticks_per_frame;
+
+    // Frames per second to pace rendering to, 0 to not limit:
+    float32_t target_frame_rate;
+
     char* name;
 } application_config;
 
+#define APPLICATION_DEFAULT_MAX_TICKS_PER_FRAME 5
+
 FAPI bool8_t application_create(struct game* game_instance);
-FAPI bool8_t application_run();
\ No newline at end of file
+FAPI bool8_t application_run();
+
+// Changes the frame rate the application paces to, 0 to not limit:
+FAPI void application_set_target_frame_rate(float32_t target_frame_rate);
+
+// Summarizes how far the length of recent paced frames strayed from the target, in seconds, overruns included:
+FAPI void application_get_frame_jitter(struct sample_summary* out_summary);
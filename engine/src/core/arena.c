@@ -0,0 +1,107 @@
+#include "core/arena.h"
+
+static uint64_t arena_align(uint64_t size)
+{
+    return (size + (ARENA_ALIGNMENT - 1)) & ~(uint64_t)(ARENA_ALIGNMENT - 1);
+}
+
+static uint8_t* arena_block_data(arena_block* block)
+{
+    return (uint8_t*)block + arena_align(sizeof(arena_block));
+}
+
+static arena_block* arena_block_create(const arena* arena, uint64_t min_capacity)
+{
+    uint64_t capacity = arena->block_size > min_capacity ? arena->block_size : min_capacity;
+    arena_block* block = fallocate(arena_align(sizeof(arena_block)) + capacity, arena->tag);
+    block->next = 0;
+    block->capacity = capacity;
+    block->used = 0;
+    return block;
+}
+
+void arena_create(uint64_t block_size, memory_tag tag, arena* out_arena)
+{
+    out_arena->first = 0;
+    out_arena->current = 0;
+    out_arena->block_size = block_size ? arena_align(block_size) : ARENA_DEFAULT_BLOCK_SIZE;
+    out_arena->tag = tag;
+}
+
+void arena_destroy(arena* arena)
+{
+    arena_block* block = arena->first;
+    while (block)
+    {
+        arena_block* next = block->next;
+        ffree(block, arena_align(sizeof(arena_block)) + block->capacity, arena->tag);
+        block = next;
+    }
+
+    arena->first = 0;
+    arena->current = 0;
+}
+
+void* arena_allocate(arena* arena, uint64_t size)
+{
+    size = arena_align(size);
+
+    // Walk forward through blocks kept from before a reset, then chain a new one if none fit:
+    while (arena->current && arena->current->used + size > arena->current->capacity)
+    {
+        if (!arena->current->next)
+        {
+            arena->current->next = arena_block_create(arena, size);
+        }
+        arena->current = arena->current->next;
+    }
+
+    if (!arena->current)
+    {
+        arena->first = arena_block_create(arena, size);
+        arena->current = arena->first;
+    }
+
+    void* memory = arena_block_data(arena->current) + arena->current->used;
+    arena->current->used += size;
+    return memory;
+}
+
+bool8_t arena_extend(arena* arena, void* block, uint64_t old_size, uint64_t new_size)
+{
+    arena_block* current = arena->current;
+    if (!current)
+    {
+        return FALSE;
+    }
+
+    old_size = arena_align(old_size);
+    new_size = arena_align(new_size);
+    uint8_t* end = arena_block_data(current) + current->used;
+    if ((uint8_t*)block + old_size != end || current->used - old_size + new_size > current->capacity)
+    {
+        return FALSE;
+    }
+
+    current->used = current->used - old_size + new_size;
+    return TRUE;
+}
+
+void arena_reset(arena* arena)
+{
+    for (arena_block* block = arena->first; block; block = block->next)
+    {
+        block->used = 0;
+    }
+    arena->current = arena->first;
+}
+
+uint64_t arena_used(const arena* arena)
+{
+    uint64_t used = 0;
+    for (arena_block* block = arena->first; block; block = block->next)
+    {
+        used += block->used;
+    }
+    return used;
+}
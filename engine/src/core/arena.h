@@ -0,0 +1,57 @@
+#pragma once
+
+#include "defines.h"
+#include "core/fmemory.h"
+
+/*
+ * Chunked bump allocator.
+ *
+ * Allocations are carved linearly out of blocks obtained from fallocate. When a block runs out, a new one is
+ * chained on, so pointers handed out stay valid until the arena is reset or destroyed. Individual allocations
+ * are never freed; arena_reset rewinds every block for reuse without returning memory to the system, which
+ * is what per-frame scratch memory wants.
+ */
+
+typedef struct arena_block
+{
+    struct arena_block* next;
+    uint64_t capacity;
+    uint64_t used;
+} arena_block;
+
+typedef struct arena
+{
+    arena_block* first;
+    arena_block* current;
+    uint64_t block_size;
+    memory_tag tag;
+} arena;
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT 8
+
+/**
+ * Creates an arena. No memory is allocated until the first allocation.
+ * @param block_size The size of each block. Allocations larger than this get a dedicated block.
+ * @param tag The memory tag blocks are allocated with.
+ * @param out_arena The arena to initialize.
+ */
+FAPI void arena_create(uint64_t block_size, memory_tag tag, arena* out_arena);
+
+// Frees all blocks.
+FAPI void arena_destroy(arena* arena);
+
+// Allocates size bytes aligned to ARENA_ALIGNMENT. The memory is not zeroed.
+FAPI void* arena_allocate(arena* arena, uint64_t size);
+
+/**
+ * Grows the most recent allocation in place if it is the last one in its block and there is room.
+ * @returns TRUE if the allocation now holds new_size bytes; otherwise FALSE and the allocation is untouched.
+ */
+FAPI bool8_t arena_extend(arena* arena, void* block, uint64_t old_size, uint64_t new_size);
+
+// Rewinds all blocks. Every pointer previously handed out becomes invalid.
+FAPI void arena_reset(arena* arena);
+
+// Returns the total amount of bytes handed out since the last reset.
+FAPI uint64_t arena_used(const arena* arena);
@@ -1,26 +1,162 @@
 #include "core/event.h"
 
 #include "core/fmemory.h"
+#include "core/arena.h"
+#include "core/fstring.h"
+#include "core/logger.h"
+#include "core/profiler.h"
 #include "containers/darray.h"
+#include "platform/platform.h"
+
+#include <stdatomic.h>
 
 typedef struct registered_event
 {
     void* listener;
+    // 0 once unregistered, the entry is skipped until the code's listeners are compacted:
     ptrfn_on_event callback;
+    // Registered through event_register_raw:
+    bool8_t raw;
+#if EVENT_STATS_ENABLED
+    // Index into the callback counters:
+    uint32_t stats_index;
+#endif
 } registered_event;
 
+/*
+ * Everything known about one code. Its listeners are kept contiguous and in registration order, which is all
+ * dispatch walks. Unregistering only clears the callback; the array is compacted once half of it is dead, and
+ * never while a handler is running, so a handler can unregister listeners without shifting memory under dispatch.
+ */
 typedef struct event_code_entry
 {
-    registered_event* events;
+    registered_event* listeners;
+    // Handle slot of each listener, parallel to listeners:
+    uint32_t* listener_slots;
+    uint32_t dead_count;
+    uint32_t raw_count;
+    // Chain of events posted with this code since the last dispatch, as indices into the posted queue:
+    uint32_t first_posted;
+    uint32_t last_posted;
+    // The posted event further posts are merged into, when the code coalesces:
+    uint32_t coalesced_posted;
+    event_coalesce_mode coalesce;
+    uint16_t code;
+#if EVENT_STATS_ENABLED
+    event_code_stats stats;
+#endif
 } event_code_entry;
 
+// Where the listener behind a handle lives. Free slots are chained through listener_index:
+typedef struct listener_slot
+{
+    uint32_t generation;
+    uint32_t code_index;
+    uint32_t listener_index;
+} listener_slot;
+
+// Which listeners a posted event goes to:
+typedef enum posted_audience
+{
+    POSTED_TO_ALL,
+    // A merged event of a coalescing code, for listeners that did not ask for raw samples:
+    POSTED_TO_COALESCED,
+    // One unmerged sample of a coalescing code, for raw listeners only:
+    POSTED_TO_RAW
+} posted_audience;
+
+// An event queued by event_post:
+typedef struct posted_event
+{
+    event_context context;
+    void* sender;
+    // Index of the next event posted with the same code, or EVENT_INDEX_NONE:
+    uint32_t next;
+    uint16_t code;
+    uint8_t audience;
+} posted_event;
+
+// A code with posted events, and the head of its chain:
+typedef struct posted_code
+{
+    uint32_t first;
+    uint32_t code_index;
+} posted_code;
+
 // This should be more than enough codes:
 #define MAX_MESSAGE_CODES 16384
 
+#define EVENT_INDEX_NONE 0xFFFFFFFF
+
+#define LISTENER_SET_INITIAL_CAPACITY 256
+
+#define EVENT_PAYLOAD_BLOCK_SIZE (64 * 1024)
+
+#define EVENT_STATS_DEFAULT_DUMP_INTERVAL 30.0
+// Callbacks listed by the report, most expensive first:
+#define EVENT_STATS_REPORT_CALLBACKS 8
+
+// Events a thread can have in flight before the main thread collects them. Must be a power of two:
+#define EVENT_THREAD_QUEUE_CAPACITY 1024
+
+/*
+ * Queue of events posted by one thread, collected by the main thread. Each queue has a single producer, so it is
+ * a plain ring with one atomic index per side; the set of queues is what gets fed by many threads.
+ */
+typedef struct event_thread_queue
+{
+    struct event_thread_queue* next;
+    // Written only by the owning thread:
+    _Atomic uint32_t write_index;
+    // Written only by the main thread:
+    _Atomic uint32_t read_index;
+    // Set by the owning thread in event_thread_release; the main thread frees the queue once it is drained:
+    _Atomic uint32_t released;
+    posted_event events[EVENT_THREAD_QUEUE_CAPACITY];
+} event_thread_queue;
+
 // State structure:
 typedef struct event_system_state
 {
-    event_code_entry registered[MAX_MESSAGE_CODES];
+    // Sparse table from code to 1 + the index of its entry in codes, or 0 if the code was never used:
+    uint16_t code_indices[MAX_MESSAGE_CODES];
+    // Dense, one entry per code that was ever registered or posted to:
+    event_code_entry* codes;
+
+    // Handle slots, and the head of the free slot chain:
+    listener_slot* slots;
+    uint32_t free_slot;
+
+    // Open-addressed set of 1 + slot index, keyed on code/listener/callback. Linear probing, power of two
+    // capacity, kept at most half full:
+    uint32_t* listener_set;
+    uint32_t listener_set_capacity;
+    uint32_t listener_count;
+
+    // Nesting depth of running handlers. Compaction is deferred while above 0:
+    uint32_t dispatch_depth;
+
+    // Events posted this frame, in posting order. Swapped with the dispatch arrays when dispatch starts, so events
+    // posted by handlers are delivered on the next dispatch:
+    posted_event* posted;
+    // Codes that have posted events, in the order their first event was posted:
+    posted_code* posted_codes;
+    posted_event* dispatching;
+    posted_code* dispatching_codes;
+
+    // Payloads of the posted events, swapped and reset along with the queues:
+    arena payloads;
+    arena dispatching_payloads;
+
+    // Every thread that ever called event_post_threaded, newest first. Queues live until shutdown:
+    _Atomic(event_thread_queue*) thread_queues;
+
+#if EVENT_STATS_ENABLED
+    // One entry per code/callback pair ever registered:
+    event_callback_stats* callback_stats;
+    float64_t stats_window_start;
+    float64_t stats_dump_interval;
+#endif
 } event_system_state;
 
 /**
@@ -29,6 +165,12 @@ typedef struct event_system_state
 static bool8_t is_initialized = FALSE;
 static event_system_state state;
 
+static _Thread_local event_thread_queue* thread_queue;
+// Queues belong to one run of the event system. A thread's queue from before a shutdown is stale, since shutdown
+// frees every queue, and is recognized by its generation instead of being touched:
+static _Thread_local uint32_t thread_queue_generation;
+static _Atomic uint32_t queue_generation;
+
 bool8_t event_initialize()
 {
     if (is_initialized == TRUE)
@@ -38,109 +180,899 @@ bool8_t event_initialize()
 
     is_initialized = FALSE;
     fzero_memory(&state, sizeof(state));
+    atomic_fetch_add_explicit(&queue_generation, 1, memory_order_relaxed);
+
+    state.codes = darray_reserve(event_code_entry, 64);
+    state.slots = darray_reserve(listener_slot, LISTENER_SET_INITIAL_CAPACITY / 2);
+    state.free_slot = EVENT_INDEX_NONE;
+    state.listener_set_capacity = LISTENER_SET_INITIAL_CAPACITY;
+    state.listener_set = fallocate(sizeof(uint32_t) * state.listener_set_capacity, MEMORY_TAG_DICT);
+    fzero_memory(state.listener_set, sizeof(uint32_t) * state.listener_set_capacity);
+
+    state.posted = darray_reserve(posted_event, 256);
+    state.posted_codes = darray_reserve(posted_code, 32);
+    state.dispatching = darray_reserve(posted_event, 256);
+    state.dispatching_codes = darray_reserve(posted_code, 32);
+    arena_create(EVENT_PAYLOAD_BLOCK_SIZE, MEMORY_TAG_EVENT, &state.payloads);
+    arena_create(EVENT_PAYLOAD_BLOCK_SIZE, MEMORY_TAG_EVENT, &state.dispatching_payloads);
+#if EVENT_STATS_ENABLED
+    state.callback_stats = darray_reserve(event_callback_stats, 64);
+    state.stats_window_start = platform_get_absolute_time();
+    state.stats_dump_interval = EVENT_STATS_DEFAULT_DUMP_INTERVAL;
+#endif
     is_initialized = TRUE;
+
+    // High-frequency input only needs to reach most listeners once per frame:
+    event_set_coalescing(EVENT_CODE_MOUSE_MOVED, EVENT_COALESCE_LATEST);
+    event_set_coalescing(EVENT_CODE_RESIZE, EVENT_COALESCE_LATEST);
+    event_set_coalescing(EVENT_CODE_MOUSE_WHEEL, EVENT_COALESCE_ACCUMULATE);
     return TRUE;
 }
 
 void event_shutdown()
 {
-    for (uint16_t i = 0; i < MAX_MESSAGE_CODES; ++i)
+    if (is_initialized == FALSE)
+    {
+        return;
+    }
+
+    uint64_t code_count = darray_length(state.codes);
+    for (uint64_t i = 0; i < code_count; ++i)
     {
-        if (state.registered[i].events == 0)
+        darray_destroy(state.codes[i].listeners);
+        darray_destroy(state.codes[i].listener_slots);
+    }
+    darray_destroy(state.codes);
+    darray_destroy(state.slots);
+    ffree(state.listener_set, sizeof(uint32_t) * state.listener_set_capacity, MEMORY_TAG_DICT);
+    state.codes = 0;
+    state.slots = 0;
+    state.listener_set = 0;
+
+    darray_destroy(state.posted);
+    darray_destroy(state.posted_codes);
+    darray_destroy(state.dispatching);
+    darray_destroy(state.dispatching_codes);
+    state.posted = 0;
+    state.posted_codes = 0;
+    state.dispatching = 0;
+    state.dispatching_codes = 0;
+    arena_destroy(&state.payloads);
+    arena_destroy(&state.dispatching_payloads);
+#if EVENT_STATS_ENABLED
+    darray_destroy(state.callback_stats);
+    state.callback_stats = 0;
+#endif
+
+    event_thread_queue* queue = atomic_exchange(&state.thread_queues, 0);
+    while (queue)
+    {
+        event_thread_queue* next = queue->next;
+        platform_free(queue, FALSE);
+        queue = next;
+    }
+    thread_queue = 0;
+
+    is_initialized = FALSE;
+}
+
+// Returns the index of the code's entry, creating the entry if asked to, or EVENT_INDEX_NONE:
+static uint32_t event_code_index(uint16_t code, bool8_t create)
+{
+    if (state.code_indices[code])
+    {
+        return state.code_indices[code] - 1u;
+    }
+
+    if (!create)
+    {
+        return EVENT_INDEX_NONE;
+    }
+
+    event_code_entry entry;
+    entry.listeners = darray_create(registered_event);
+    entry.listener_slots = darray_create(uint32_t);
+    entry.dead_count = 0;
+    entry.raw_count = 0;
+    entry.first_posted = EVENT_INDEX_NONE;
+    entry.last_posted = EVENT_INDEX_NONE;
+    entry.coalesced_posted = EVENT_INDEX_NONE;
+    entry.coalesce = EVENT_COALESCE_NONE;
+    entry.code = code;
+#if EVENT_STATS_ENABLED
+    fzero_memory(&entry.stats, sizeof(entry.stats));
+    entry.stats.code = code;
+#endif
+    darray_push(state.codes, entry);
+    state.code_indices[code] = (uint16_t)darray_length(state.codes);
+    return state.code_indices[code] - 1u;
+}
+
+static void event_code_compact(event_code_entry* entry)
+{
+    uint64_t count = darray_length(entry->listeners);
+    uint64_t kept = 0;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (!entry->listeners[i].callback)
         {
             continue;
         }
 
-        darray_destroy(state.registered[i].events);
-        state.registered[i].events = 0;
+        entry->listeners[kept] = entry->listeners[i];
+        entry->listener_slots[kept] = entry->listener_slots[i];
+        state.slots[entry->listener_slots[kept]].listener_index = (uint32_t)kept;
+        kept++;
     }
+
+    darray_length_set(entry->listeners, kept);
+    darray_length_set(entry->listener_slots, kept);
+    entry->dead_count = 0;
 }
 
-bool8_t event_register(uint16_t code, void* listener, ptrfn_on_event on_event)
+static uint32_t listener_hash(uint16_t code, void* listener, ptrfn_on_event callback)
 {
-    if (is_initialized == FALSE)
+    uint64_t key = ((uint64_t)listener * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)callback + code);
+    key ^= key >> 31;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 29;
+    return (uint32_t)key;
+}
+
+static const registered_event* listener_from_slot(uint32_t slot_index)
+{
+    const listener_slot* slot = &state.slots[slot_index];
+    return &state.codes[slot->code_index].listeners[slot->listener_index];
+}
+
+static uint32_t listener_set_hash_entry(uint32_t set_entry)
+{
+    const registered_event* e = listener_from_slot(set_entry - 1);
+    return listener_hash(state.codes[state.slots[set_entry - 1].code_index].code, e->listener, e->callback);
+}
+
+// Returns the position of the registration in the listener set, or the empty position it would be inserted at:
+static uint32_t listener_set_find(uint16_t code, void* listener, ptrfn_on_event callback)
+{
+    uint32_t mask = state.listener_set_capacity - 1;
+    uint32_t position = listener_hash(code, listener, callback) & mask;
+    for (;; position = (position + 1) & mask)
     {
-        return FALSE;
+        uint32_t set_entry = state.listener_set[position];
+        if (set_entry == 0)
+        {
+            return position;
+        }
+
+        const registered_event* e = listener_from_slot(set_entry - 1);
+        if (e->listener == listener && e->callback == callback &&
+            state.codes[state.slots[set_entry - 1].code_index].code == code)
+        {
+            return position;
+        }
     }
+}
+
+static void listener_set_grow()
+{
+    uint32_t* old_set = state.listener_set;
+    uint32_t old_capacity = state.listener_set_capacity;
 
-    if (state.registered[code].events == 0)
+    state.listener_set_capacity = old_capacity * 2;
+    state.listener_set = fallocate(sizeof(uint32_t) * state.listener_set_capacity, MEMORY_TAG_DICT);
+    fzero_memory(state.listener_set, sizeof(uint32_t) * state.listener_set_capacity);
+
+    uint32_t mask = state.listener_set_capacity - 1;
+    for (uint32_t i = 0; i < old_capacity; ++i)
     {
-        state.registered[code].events = darray_create(registered_event);
+        if (old_set[i] == 0)
+        {
+            continue;
+        }
+
+        uint32_t position = listener_set_hash_entry(old_set[i]) & mask;
+        while (state.listener_set[position])
+        {
+            position = (position + 1) & mask;
+        }
+        state.listener_set[position] = old_set[i];
     }
 
-    uint64_t registered_count = darray_length(state.registered[code].events);
-    for (uint64_t i = 0; i < registered_count; ++i)
+    ffree(old_set, sizeof(uint32_t) * old_capacity, MEMORY_TAG_DICT);
+}
+
+// Removes the entry at position, shifting later entries of the probe run back so lookups need no tombstones:
+static void listener_set_remove(uint32_t position)
+{
+    uint32_t mask = state.listener_set_capacity - 1;
+    uint32_t hole = position;
+    for (uint32_t next = (hole + 1) & mask; state.listener_set[next]; next = (next + 1) & mask)
     {
-        if (state.registered[code].events[i].listener == listener)
+        // An entry may move into the hole only if the hole is not before its home position:
+        uint32_t home = listener_set_hash_entry(state.listener_set[next]) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask))
         {
-            // TODO: warn
-            return FALSE;
+            state.listener_set[hole] = state.listener_set[next];
+            hole = next;
         }
     }
 
+    state.listener_set[hole] = 0;
+    state.listener_count--;
+}
+
+static uint32_t listener_slot_allocate()
+{
+    if (state.free_slot != EVENT_INDEX_NONE)
+    {
+        uint32_t slot_index = state.free_slot;
+        state.free_slot = state.slots[slot_index].listener_index;
+        return slot_index;
+    }
+
+    listener_slot slot = { 1, EVENT_INDEX_NONE, EVENT_INDEX_NONE };
+    darray_push(state.slots, slot);
+    return (uint32_t)darray_length(state.slots) - 1;
+}
+
+// Unregisters the listener in slot_index, which sits at set_position in the listener set:
+static void listener_remove(uint32_t slot_index, uint32_t set_position)
+{
+    listener_set_remove(set_position);
+
+    listener_slot* slot = &state.slots[slot_index];
+    event_code_entry* entry = &state.codes[slot->code_index];
+    if (entry->listeners[slot->listener_index].raw)
+    {
+        entry->raw_count--;
+    }
+    entry->listeners[slot->listener_index].listener = 0;
+    entry->listeners[slot->listener_index].callback = 0;
+    entry->listener_slots[slot->listener_index] = EVENT_INDEX_NONE;
+    entry->dead_count++;
+
+    // Invalidate outstanding handles to the slot before reusing it:
+    slot->generation++;
+    slot->code_index = EVENT_INDEX_NONE;
+    slot->listener_index = state.free_slot;
+    state.free_slot = slot_index;
+
+    if (state.dispatch_depth == 0 && entry->dead_count * 2 > darray_length(entry->listeners))
+    {
+        event_code_compact(entry);
+    }
+}
+
+#if EVENT_STATS_ENABLED
+// Returns the counters shared by every registration of callback for code, creating them on first use:
+static uint32_t event_callback_stats_index(uint16_t code, ptrfn_on_event callback)
+{
+    uint64_t count = darray_length(state.callback_stats);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (state.callback_stats[i].code == code && state.callback_stats[i].callback == callback)
+        {
+            return (uint32_t)i;
+        }
+    }
+
+    event_callback_stats stats;
+    fzero_memory(&stats, sizeof(stats));
+    stats.code = code;
+    stats.callback = callback;
+    darray_push(state.callback_stats, stats);
+    return (uint32_t)count;
+}
+#endif
+
+static event_handle event_register_listener(uint16_t code, void* listener, ptrfn_on_event on_event, bool8_t raw)
+{
+    if (is_initialized == FALSE || code >= MAX_MESSAGE_CODES || !on_event)
+    {
+        return INVALID_EVENT_HANDLE;
+    }
+
+    if ((state.listener_count + 1) * 2 > state.listener_set_capacity)
+    {
+        listener_set_grow();
+    }
+
+    uint32_t position = listener_set_find(code, listener, on_event);
+    if (state.listener_set[position])
+    {
+        // TODO: warn
+        return INVALID_EVENT_HANDLE;
+    }
+
     // If at this point, no duplicates were found, Proceed with registration:
+    uint32_t code_index = event_code_index(code, TRUE);
+    uint32_t slot_index = listener_slot_allocate();
+    event_code_entry* entry = &state.codes[code_index];
+    listener_slot* slot = &state.slots[slot_index];
+    slot->code_index = code_index;
+    slot->listener_index = (uint32_t)darray_length(entry->listeners);
+
     registered_event event;
     event.listener = listener;
     event.callback = on_event;
-    darray_push(state.registered[code].events, event);
-    return TRUE;
+    event.raw = raw;
+#if EVENT_STATS_ENABLED
+    event.stats_index = event_callback_stats_index(code, on_event);
+#endif
+    darray_push(entry->listeners, event);
+    darray_push(entry->listener_slots, slot_index);
+    if (raw)
+    {
+        entry->raw_count++;
+    }
+
+    state.listener_set[position] = slot_index + 1;
+    state.listener_count++;
+    return ((uint64_t)slot->generation << 32) | (slot_index + 1);
+}
+
+event_handle event_register(uint16_t code, void* listener, ptrfn_on_event on_event)
+{
+    return event_register_listener(code, listener, on_event, FALSE);
+}
+
+event_handle event_register_raw(uint16_t code, void* listener, ptrfn_on_event on_event)
+{
+    return event_register_listener(code, listener, on_event, TRUE);
 }
 
 bool8_t event_unregister(uint16_t code, void* listener, ptrfn_on_event on_event)
 {
-    if (is_initialized == FALSE)
+    if (is_initialized == FALSE || code >= MAX_MESSAGE_CODES)
     {
         return FALSE;
     }
 
-    // On nothing is registered for the code, early out.
-    if (state.registered[code].events == 0)
+    uint32_t position = listener_set_find(code, listener, on_event);
+    if (state.listener_set[position] == 0)
     {
         // TODO: warn
         return FALSE;
     }
 
-    uint64_t registered_count = darray_length(state.registered[code].events);
+    listener_remove(state.listener_set[position] - 1, position);
+    return TRUE;
+}
+
+bool8_t event_unregister_handle(event_handle handle)
+{
+    if (is_initialized == FALSE || handle == INVALID_EVENT_HANDLE)
+    {
+        return FALSE;
+    }
+
+    // A stale handle has an older generation than its slot:
+    uint32_t slot_index = (uint32_t)handle - 1;
+    if (slot_index >= darray_length(state.slots) || state.slots[slot_index].generation != (uint32_t)(handle >> 32))
+    {
+        return FALSE;
+    }
+
+    const registered_event* e = listener_from_slot(slot_index);
+    uint16_t code = state.codes[state.slots[slot_index].code_index].code;
+    listener_remove(slot_index, listener_set_find(code, e->listener, e->callback));
+    return TRUE;
+}
+
+// Invokes the code's listeners in registration order until one handles the event:
+static bool8_t event_deliver(uint32_t code_index, uint16_t code, void* sender, event_context context,
+    posted_audience audience)
+{
+    bool8_t handled = FALSE;
+    state.dispatch_depth++;
+#if EVENT_STATS_ENABLED
+    uint64_t calls = 0;
+    float64_t event_start = platform_get_absolute_time();
+#endif
+
+    // N.B: Listeners registered by a handler only see later events. The array is re-read every iteration, since
+    // registering may have grown it:
+    uint64_t registered_count = darray_length(state.codes[code_index].listeners);
     for (uint64_t i = 0; i < registered_count; ++i)
     {
-        registered_event e = state.registered[code].events[i];
-        if (e.listener != listener && e.callback != on_event)
+        registered_event e = state.codes[code_index].listeners[i];
+        if (!e.callback || (audience == POSTED_TO_RAW && !e.raw) || (audience == POSTED_TO_COALESCED && e.raw))
         {
             continue;
         }
 
-        // TODO: Possible candidate to PopAndSwap given that order in events is irrelevant
-        registered_event popped_event;
-        darray_pop_at(state.registered[code].events, i, &popped_event);
-        return TRUE;
+#if EVENT_STATS_ENABLED
+        float64_t call_start = platform_get_absolute_time();
+#endif
+        bool8_t call_handled = e.callback(code, sender, e.listener, context);
+#if EVENT_STATS_ENABLED
+        float64_t call_seconds = platform_get_absolute_time() - call_start;
+        event_callback_stats* callback_stats = &state.callback_stats[e.stats_index];
+        callback_stats->call_count++;
+        callback_stats->handled_count += call_handled ? 1 : 0;
+        callback_stats->seconds += call_seconds;
+        if (call_seconds > callback_stats->max_seconds)
+        {
+            callback_stats->max_seconds = call_seconds;
+        }
+        calls++;
+#endif
+        if (call_handled)
+        {
+            handled = TRUE;
+            break;
+        }
     }
 
-    return FALSE;
+#if EVENT_STATS_ENABLED
+    // Looked up again, a handler may have added codes and moved the entries:
+    float64_t event_seconds = platform_get_absolute_time() - event_start;
+    event_code_stats* stats = &state.codes[code_index].stats;
+    stats->delivered_count++;
+    stats->handled_count += handled ? 1 : 0;
+    stats->handler_calls += calls;
+    stats->handler_seconds += event_seconds;
+    if (event_seconds > stats->max_event_seconds)
+    {
+        stats->max_event_seconds = event_seconds;
+    }
+#endif
+
+    state.dispatch_depth--;
+    return handled;
 }
 
 bool8_t event_fire(uint16_t code, void* sender, event_context context)
 {
-    if (is_initialized == FALSE)
+    if (is_initialized == FALSE || code >= MAX_MESSAGE_CODES)
     {
         return FALSE;
     }
 
     // If nothing is registered, early out:
-    if (state.registered[code].events == 0)
+    uint32_t code_index = event_code_index(code, FALSE);
+    if (code_index == EVENT_INDEX_NONE)
     {
         // TODO: warn
         return FALSE;
     }
 
-    uint64_t registered_count = darray_length(state.registered[code].events);
-    for (uint64_t i = 0; i < registered_count; ++i)
+#if EVENT_STATS_ENABLED
+    state.codes[code_index].stats.fired_count++;
+#endif
+    PROFILE_ZONE_BEGIN("event_fire");
+    bool8_t handled = event_deliver(code_index, code, sender, context, POSTED_TO_ALL);
+    PROFILE_ZONE_END();
+    return handled;
+}
+
+// Appends an event to the posted queue and links it onto its code's chain:
+static uint32_t event_post_append(uint32_t code_index, uint16_t code, void* sender, event_context context,
+    posted_audience audience)
+{
+    // Chaining per code lets dispatch walk one code at a time without sorting:
+    uint32_t index = (uint32_t)darray_length(state.posted);
+    event_code_entry* entry = &state.codes[code_index];
+    if (entry->last_posted == EVENT_INDEX_NONE)
     {
-        registered_event e = state.registered[code].events[i];
-        if (e.callback(code, sender, e.listener, context))
+        posted_code first = { index, code_index };
+        darray_push(state.posted_codes, first);
+        entry->first_posted = index;
+    }
+    else
+    {
+        state.posted[entry->last_posted].next = index;
+    }
+    entry->last_posted = index;
+
+    posted_event event;
+    event.context = context;
+    event.sender = sender;
+    event.next = EVENT_INDEX_NONE;
+    event.code = code;
+    event.audience = (uint8_t)audience;
+    darray_push(state.posted, event);
+    return index;
+}
+
+bool8_t event_post(uint16_t code, void* sender, event_context context)
+{
+    if (is_initialized == FALSE || code >= MAX_MESSAGE_CODES)
+    {
+        return FALSE;
+    }
+
+    uint32_t code_index = event_code_index(code, TRUE);
+    event_code_entry* entry = &state.codes[code_index];
+#if EVENT_STATS_ENABLED
+    entry->stats.posted_count++;
+#endif
+    if (entry->coalesce == EVENT_COALESCE_NONE)
+    {
+        event_post_append(code_index, code, sender, context, POSTED_TO_ALL);
+        return TRUE;
+    }
+
+    // Raw listeners still get every sample, as an event of its own:
+    if (entry->raw_count)
+    {
+        event_post_append(code_index, code, sender, context, POSTED_TO_RAW);
+    }
+
+    if (entry->coalesced_posted == EVENT_INDEX_NONE)
+    {
+        entry->coalesced_posted = event_post_append(code_index, code, sender, context, POSTED_TO_COALESCED);
+        return TRUE;
+    }
+
+    // Merge into the event already pending this frame, which keeps the position of the first sample:
+    posted_event* pending = &state.posted[entry->coalesced_posted];
+    pending->sender = sender;
+    if (entry->coalesce == EVENT_COALESCE_LATEST)
+    {
+        pending->context = context;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            pending->context.data.u32[i] += context.data.u32[i];
+        }
+    }
+    return TRUE;
+}
+
+void event_set_coalescing(uint16_t code, event_coalesce_mode mode)
+{
+    if (is_initialized == FALSE || code >= MAX_MESSAGE_CODES)
+    {
+        return;
+    }
+
+    state.codes[event_code_index(code, TRUE)].coalesce = mode;
+}
+
+uint32_t event_dispatch_posted()
+{
+    if (is_initialized == FALSE || darray_length(state.posted) == 0)
+    {
+        return 0;
+    }
+
+    // Take this frame's events and detach the chains from the code table, so anything posted from a handler
+    // starts a fresh queue for the next dispatch:
+    posted_event* events = state.posted;
+    posted_code* codes = state.posted_codes;
+    state.posted = state.dispatching;
+    state.posted_codes = state.dispatching_codes;
+
+    arena payloads = state.payloads;
+    state.payloads = state.dispatching_payloads;
+
+    uint64_t code_count = darray_length(codes);
+    for (uint64_t i = 0; i < code_count; ++i)
+    {
+        event_code_entry* entry = &state.codes[codes[i].code_index];
+        entry->first_posted = EVENT_INDEX_NONE;
+        entry->last_posted = EVENT_INDEX_NONE;
+        entry->coalesced_posted = EVENT_INDEX_NONE;
+    }
+
+    // Deliver one code at a time, so the same handlers stay hot for the whole group. Events of a code keep their
+    // posting order, and groups run in the order their first event was posted:
+    uint32_t dispatched = 0;
+    for (uint64_t i = 0; i < code_count; ++i)
+    {
+        for (uint32_t index = codes[i].first; index != EVENT_INDEX_NONE; index = events[index].next)
+        {
+            posted_event* event = &events[index];
+            event_deliver(codes[i].code_index, event->code, event->sender, event->context, event->audience);
+            dispatched++;
+        }
+    }
+
+    darray_clear(events);
+    darray_clear(codes);
+    state.dispatching = events;
+    state.dispatching_codes = codes;
+
+    // Keeps its blocks, so steady-state payload traffic does not allocate:
+    arena_reset(&payloads);
+    state.dispatching_payloads = payloads;
+    return dispatched;
+}
+
+void* event_payload_allocate(uint64_t size)
+{
+    if (is_initialized == FALSE)
+    {
+        return 0;
+    }
+
+    return arena_allocate(&state.payloads, size);
+}
+
+bool8_t event_post_payload(uint16_t code, void* sender, void* payload, uint64_t size)
+{
+    event_context context;
+    context.data.payload.data = payload;
+    context.data.payload.size = size;
+    return event_post(code, sender, context);
+}
+
+bool8_t event_post_threaded(uint16_t code, void* sender, event_context context)
+{
+    if (is_initialized == FALSE || code >= MAX_MESSAGE_CODES)
+    {
+        return FALSE;
+    }
+
+    uint32_t generation = atomic_load_explicit(&queue_generation, memory_order_relaxed);
+    event_thread_queue* queue = thread_queue_generation == generation ? thread_queue : 0;
+    if (!queue)
+    {
+        // N.B: Not through fallocate, its usage counters are only safe to touch from the main thread:
+        queue = platform_allocate(sizeof(event_thread_queue), FALSE);
+        platform_zero_memory(queue, sizeof(event_thread_queue));
+        atomic_init(&queue->write_index, 0);
+        atomic_init(&queue->read_index, 0);
+        atomic_init(&queue->released, 0);
+
+        event_thread_queue* head = atomic_load_explicit(&state.thread_queues, memory_order_relaxed);
+        do
+        {
+            queue->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&state.thread_queues, &head, queue, memory_order_release,
+            memory_order_relaxed));
+        thread_queue = queue;
+        thread_queue_generation = generation;
+    }
+
+    uint32_t write_index = atomic_load_explicit(&queue->write_index, memory_order_relaxed);
+    uint32_t read_index = atomic_load_explicit(&queue->read_index, memory_order_acquire);
+    if (write_index - read_index >= EVENT_THREAD_QUEUE_CAPACITY)
+    {
+        return FALSE;
+    }
+
+    posted_event* event = &queue->events[write_index & (EVENT_THREAD_QUEUE_CAPACITY - 1)];
+    event->context = context;
+    event->sender = sender;
+    event->next = EVENT_INDEX_NONE;
+    event->code = code;
+    atomic_store_explicit(&queue->write_index, write_index + 1, memory_order_release);
+    return TRUE;
+}
+
+uint32_t event_collect_threaded()
+{
+    if (is_initialized == FALSE)
+    {
+        return 0;
+    }
+
+    uint32_t collected = 0;
+    event_thread_queue* previous = 0;
+    event_thread_queue* queue = atomic_load_explicit(&state.thread_queues, memory_order_acquire);
+    while (queue)
+    {
+        // Read before draining: a released queue then holds everything its thread will ever post:
+        bool8_t released = atomic_load_explicit(&queue->released, memory_order_acquire) != 0;
+
+        uint32_t read_index = atomic_load_explicit(&queue->read_index, memory_order_relaxed);
+        uint32_t write_index = atomic_load_explicit(&queue->write_index, memory_order_acquire);
+        for (; read_index != write_index; ++read_index)
+        {
+            posted_event* event = &queue->events[read_index & (EVENT_THREAD_QUEUE_CAPACITY - 1)];
+            event_post(event->code, event->sender, event->context);
+            collected++;
+        }
+        atomic_store_explicit(&queue->read_index, read_index, memory_order_release);
+
+        event_thread_queue* next = queue->next;
+        if (!released)
+        {
+            previous = queue;
+            queue = next;
+            continue;
+        }
+
+        // Unlink it. Other threads only ever push onto the head, so only unlinking the head can race with them:
+        if (previous)
         {
-            return TRUE;
+            previous->next = next;
         }
+        else
+        {
+            event_thread_queue* head = queue;
+            if (!atomic_compare_exchange_strong_explicit(&state.thread_queues, &head, next, memory_order_acquire,
+                memory_order_acquire))
+            {
+                // New queues were pushed in front of it; it has a predecessor now:
+                while (head->next != queue)
+                {
+                    head = head->next;
+                }
+                head->next = next;
+            }
+        }
+        platform_free(queue, FALSE);
+        queue = next;
+    }
+
+    return collected;
+}
+
+void event_thread_release()
+{
+    uint32_t generation = atomic_load_explicit(&queue_generation, memory_order_relaxed);
+    if (thread_queue && thread_queue_generation == generation)
+    {
+        atomic_store_explicit(&thread_queue->released, 1, memory_order_release);
+    }
+    thread_queue = 0;
+}
+
+bool8_t event_stats_get_code(uint16_t code, event_code_stats* out_stats)
+{
+#if EVENT_STATS_ENABLED
+    if (is_initialized == FALSE || code >= MAX_MESSAGE_CODES)
+    {
+        return FALSE;
+    }
+
+    uint32_t code_index = event_code_index(code, FALSE);
+    if (code_index == EVENT_INDEX_NONE)
+    {
+        return FALSE;
     }
 
+    const event_code_entry* entry = &state.codes[code_index];
+    *out_stats = entry->stats;
+    out_stats->listener_count = (uint32_t)(darray_length(entry->listeners) - entry->dead_count);
+    return TRUE;
+#else
     return FALSE;
-}
\ No newline at end of file
+#endif
+}
+
+uint32_t event_stats_get_callbacks(event_callback_stats* out_stats, uint32_t max_count)
+{
+#if EVENT_STATS_ENABLED
+    if (is_initialized == FALSE)
+    {
+        return 0;
+    }
+
+    uint32_t count = (uint32_t)darray_length(state.callback_stats);
+    if (out_stats)
+    {
+        platform_copy_memory(out_stats, state.callback_stats,
+            sizeof(event_callback_stats) * (count < max_count ? count : max_count));
+    }
+    return count;
+#else
+    return 0;
+#endif
+}
+
+void event_stats_reset()
+{
+#if EVENT_STATS_ENABLED
+    if (is_initialized == FALSE)
+    {
+        return;
+    }
+
+    uint64_t code_count = darray_length(state.codes);
+    for (uint64_t i = 0; i < code_count; ++i)
+    {
+        fzero_memory(&state.codes[i].stats, sizeof(event_code_stats));
+        state.codes[i].stats.code = state.codes[i].code;
+    }
+
+    uint64_t callback_count = darray_length(state.callback_stats);
+    for (uint64_t i = 0; i < callback_count; ++i)
+    {
+        state.callback_stats[i].call_count = 0;
+        state.callback_stats[i].handled_count = 0;
+        state.callback_stats[i].seconds = 0;
+        state.callback_stats[i].max_seconds = 0;
+    }
+
+    state.stats_window_start = platform_get_absolute_time();
+#endif
+}
+
+void event_stats_report(struct string_builder* builder)
+{
+#if EVENT_STATS_ENABLED
+    if (is_initialized == FALSE)
+    {
+        return;
+    }
+
+    string_builder_append_format(builder, "Event stats over the last %.2fs:\n",
+        platform_get_absolute_time() - state.stats_window_start);
+
+    uint64_t code_count = darray_length(state.codes);
+    for (uint64_t i = 0; i < code_count; ++i)
+    {
+        const event_code_entry* entry = &state.codes[i];
+        if (entry->stats.delivered_count == 0 && entry->stats.posted_count == 0)
+        {
+            continue;
+        }
+
+        string_builder_append_format(builder,
+            " code %u: %llu delivered (%llu fired, %llu posted), %llu handled, %llu listeners, %llu calls, "
+            "%.3fms total, %.3fms max\n",
+            entry->code, entry->stats.delivered_count, entry->stats.fired_count, entry->stats.posted_count,
+            entry->stats.handled_count, darray_length(entry->listeners) - entry->dead_count, entry->stats.handler_calls,
+            entry->stats.handler_seconds * 1000.0, entry->stats.max_event_seconds * 1000.0);
+    }
+
+    // Most expensive callbacks first, by picking the next most expensive one not listed yet:
+    uint64_t callback_count = darray_length(state.callback_stats);
+    float64_t previous_seconds = -1.0;
+    uint64_t previous_index = callback_count;
+    for (uint32_t listed = 0; listed < EVENT_STATS_REPORT_CALLBACKS; ++listed)
+    {
+        uint64_t best = callback_count;
+        for (uint64_t i = 0; i < callback_count; ++i)
+        {
+            const event_callback_stats* candidate = &state.callback_stats[i];
+            bool8_t after_previous = previous_seconds < 0 || candidate->seconds < previous_seconds ||
+                (candidate->seconds == previous_seconds && i > previous_index);
+            if (candidate->call_count && after_previous &&
+                (best == callback_count || candidate->seconds > state.callback_stats[best].seconds))
+            {
+                best = i;
+            }
+        }
+
+        if (best == callback_count)
+        {
+            break;
+        }
+
+        const event_callback_stats* stats = &state.callback_stats[best];
+        string_builder_append_format(builder, " callback %p (code %u): %llu calls, %llu handled, %.3fms total, "
+            "%.3fms max\n", (void*)stats->callback, stats->code, stats->call_count, stats->handled_count,
+            stats->seconds * 1000.0, stats->max_seconds * 1000.0);
+        previous_seconds = stats->seconds;
+        previous_index = best;
+    }
+#endif
+}
+
+void event_stats_set_dump_interval(float64_t seconds)
+{
+#if EVENT_STATS_ENABLED
+    state.stats_dump_interval = seconds;
+#endif
+}
+
+void event_stats_update()
+{
+#if EVENT_STATS_ENABLED
+    if (is_initialized == FALSE || state.stats_dump_interval <= 0)
+    {
+        return;
+    }
+
+    if (platform_get_absolute_time() - state.stats_window_start < state.stats_dump_interval)
+    {
+        return;
+    }
+
+    char report_buffer[4096];
+    string_builder report;
+    string_builder_create_from_buffer(report_buffer, sizeof(report_buffer), 0, &report);
+    event_stats_report(&report);
+    FDEBUG("%s", string_builder_cstr(&report));
+    string_builder_destroy(&report);
+
+    event_stats_reset();
+#endif
+}
@@ -2,6 +2,8 @@
 
 #include "defines.h"
 
+struct string_builder;
+
 typedef struct event_context
 {
     // 128 bytes
@@ -22,6 +24,13 @@ typedef struct event_context
         uint8_t u8[16];
 
         char c[16];
+
+        // Events posted with event_post_payload:
+        struct
+        {
+            void* data;
+            uint64_t size;
+        } payload;
     } data;
 } event_context;
 
@@ -31,15 +40,20 @@ typedef bool8_t (*ptrfn_on_event)(uint16_t code, void* sender, void* listener_li
 bool8_t event_initialize();
 void event_shutdown();
 
+// Identifies one registration. Stays unique after the registration is removed, so a stale handle is harmless:
+typedef uint64_t event_handle;
+
+#define INVALID_EVENT_HANDLE 0
+
 /**
  * Register to listen for when events are sent with the provided code. Events with duplicate listener/callback combos
- * will not be registered again and will cause this to return FALSE.
+ * will not be registered again and will cause this to return INVALID_EVENT_HANDLE.
  * @param code The event code to listen for.
  * @param listener A pointer to a listener instance. Can be 0/NULL.
  * @param on_event The callback function ptr to be invoked when the event code is fired.
- * @returns TRUE if the event is successfully registered; otherwise FALSE.
+ * @returns A handle to the registration if the event is successfully registered; otherwise INVALID_EVENT_HANDLE.
  */
-FAPI bool8_t event_register(uint16_t code, void* listener, ptrfn_on_event on_event);
+FAPI event_handle event_register(uint16_t code, void* listener, ptrfn_on_event on_event);
 
 /**
  * Unregister from listening for when events are sent with the provided code. If no matching registration is found, this
@@ -51,6 +65,21 @@ FAPI bool8_t event_register(uint16_t code, void* listener, ptrfn_on_event on_eve
  */
 FAPI bool8_t event_unregister(uint16_t code, void* listener, ptrfn_on_event on_event);
 
+/**
+ * Like event_register, but the listener receives every raw sample posted for a code that coalesces (see
+ * event_set_coalescing), instead of the merged event. For consumers such as gesture recognition or drawing tools
+ * that need the full input stream. Raw listeners get one delivery per sample and none for the merged event.
+ * @returns A handle to the registration if the event is successfully registered; otherwise INVALID_EVENT_HANDLE.
+ */
+FAPI event_handle event_register_raw(uint16_t code, void* listener, ptrfn_on_event on_event);
+
+/**
+ * Removes the registration a handle was returned for, in constant time.
+ * @param handle The handle returned by event_register.
+ * @returns TRUE if the event is successfully unregistered; FALSE if the handle is invalid or was already unregistered.
+ */
+FAPI bool8_t event_unregister_handle(event_handle handle);
+
 /**
  * Fires an event to listeners of the given code. If an event handler returns TRUE, the event is considered handled and
  * is not passed on to any more listeners.
@@ -61,6 +90,161 @@ FAPI bool8_t event_unregister(uint16_t code, void* listener, ptrfn_on_event on_e
  */
 FAPI bool8_t event_fire(uint16_t code, void* sender, event_context context);
 
+/**
+ * Queues an event for the next dispatch phase instead of invoking listeners on the caller's stack. Listeners see
+ * the event exactly as if it had been fired, with the same handled/stop semantics. Main thread only.
+ * N.B: Posted events are delivered grouped by code, so the relative order of events with different codes is not
+ * kept. Use event_fire where a handler has to observe ordering across codes.
+ * @param code The event code to post.
+ * @param sender A pointer to the sender. Can be 0/NULL. Must still be valid when the event is dispatched.
+ * @param data The event data.
+ * @returns TRUE if the event was queued; otherwise FALSE.
+ */
+FAPI bool8_t event_post(uint16_t code, void* sender, event_context context);
+
+// How repeated posts of one code within a frame are merged before dispatch:
+typedef enum event_coalesce_mode
+{
+    // Every post is delivered:
+    EVENT_COALESCE_NONE,
+    // Only the most recent post's context and sender are delivered:
+    EVENT_COALESCE_LATEST,
+    // The contexts are added together as four 32-bit lanes. Narrower integers at the start of a lane (e.g. the
+    // wheel delta in u8[0]) wrap within their own width, so signed deltas still sum correctly.
+    EVENT_COALESCE_ACCUMULATE
+} event_coalesce_mode;
+
+/**
+ * Sets how posted events of a code are merged, so listeners see at most one event of that code per dispatch. The
+ * merged event is delivered where the first post of the frame would have been. Events sent with event_fire are
+ * never merged. Mouse moves and resizes default to EVENT_COALESCE_LATEST, wheel to EVENT_COALESCE_ACCUMULATE.
+ * @param code The event code.
+ * @param mode The coalescing mode. EVENT_COALESCE_NONE delivers every post to every listener.
+ */
+FAPI void event_set_coalescing(uint16_t code, event_coalesce_mode mode);
+
+/**
+ * Allocates memory for the payload of an event to be posted with event_post_payload, for events that carry more
+ * than the 16 bytes of event_context (asset loaded, collision batches, ...). The memory comes out of a per-frame
+ * arena and stays valid until the dispatch that delivers the events posted this frame has finished, so producers
+ * write into it directly and listeners read it in place. Main thread only.
+ * @param size The payload size in bytes.
+ * @returns The payload memory, 8-byte aligned and not zeroed, or 0 if the event system is not running.
+ */
+FAPI void* event_payload_allocate(uint64_t size);
+
+/**
+ * Posts an event that references a payload instead of carrying it by value. Listeners find it in
+ * context.data.payload; the payload is never copied. Should not be used with codes set to EVENT_COALESCE_ACCUMULATE.
+ * @param code The event code to post.
+ * @param sender A pointer to the sender. Can be 0/NULL. Must still be valid when the event is dispatched.
+ * @param payload Memory returned by event_payload_allocate this frame.
+ * @param size The payload size in bytes.
+ * @returns TRUE if the event was queued; otherwise FALSE.
+ */
+FAPI bool8_t event_post_payload(uint16_t code, void* sender, void* payload, uint64_t size);
+
+/**
+ * Delivers every event posted since the last dispatch, one code at a time. Events posted by handlers during the
+ * dispatch are kept for the next one. Payloads of the delivered events are released afterwards. Called once per
+ * frame by the application.
+ * @returns The number of events dispatched.
+ */
+uint32_t event_dispatch_posted();
+
+/**
+ * Thread-safe variant of event_post, for job workers and I/O threads. The event is queued on a queue owned by the
+ * calling thread and handed to the main thread by event_collect_threaded, then dispatched like any posted event.
+ * Never blocks and never takes a lock. Events from one thread keep their order relative to each other.
+ * N.B: Threads must stop posting before event_shutdown. Each posting thread keeps its queue until then, or until it
+ * calls event_thread_release.
+ * @param code The event code to post.
+ * @param sender A pointer to the sender. Can be 0/NULL. Must still be valid when the event is dispatched.
+ * @param data The event data.
+ * @returns TRUE if the event was queued; FALSE if the calling thread's queue is full or the system is not running.
+ */
+FAPI bool8_t event_post_threaded(uint16_t code, void* sender, event_context context);
+
+/**
+ * Moves events posted through event_post_threaded onto the main thread's posted queue, so the next
+ * event_dispatch_posted delivers them. Main thread only. Called once per frame by the application.
+ * @returns The number of events collected.
+ */
+uint32_t event_collect_threaded();
+
+/**
+ * Gives up the calling thread's event_post_threaded queue, e.g. before the thread exits. Events already posted are
+ * still delivered; the main thread frees the queue once it has collected them. Posting again afterwards creates a
+ * new queue, whose events are not ordered against those posted before the release.
+ */
+FAPI void event_thread_release();
+
+// -- Instrumentation --
+// Counts deliveries and times every handler call, per code and per callback, so a frame spike can be traced back
+// to a listener. Compiled out of release builds unless the build overrides it; the functions below then report
+// nothing.
+#ifndef EVENT_STATS_ENABLED
+#if FRELEASE == 1
+#define EVENT_STATS_ENABLED 0
+#else
+#define EVENT_STATS_ENABLED 1
+#endif
+#endif
+
+// Counters cover the time since the last dump or event_stats_reset. Handler times include nested events:
+typedef struct event_code_stats
+{
+    uint16_t code;
+    uint32_t listener_count;
+    // Events passed to listeners, whether fired or posted:
+    uint64_t delivered_count;
+    uint64_t fired_count;
+    uint64_t posted_count;
+    // Deliveries a listener returned TRUE for:
+    uint64_t handled_count;
+    uint64_t handler_calls;
+    float64_t handler_seconds;
+    // The longest time spent delivering a single event:
+    float64_t max_event_seconds;
+} event_code_stats;
+
+// Aggregated over every registration of a callback for a code:
+typedef struct event_callback_stats
+{
+    uint16_t code;
+    ptrfn_on_event callback;
+    uint64_t call_count;
+    uint64_t handled_count;
+    float64_t seconds;
+    float64_t max_seconds;
+} event_callback_stats;
+
+/**
+ * Gets the counters for a code.
+ * @returns TRUE if out_stats was filled; FALSE if instrumentation is compiled out or the code was never used.
+ */
+FAPI bool8_t event_stats_get_code(uint16_t code, event_code_stats* out_stats);
+
+/**
+ * Copies the per-callback counters into out_stats.
+ * @param out_stats Array of max_count entries. Can be 0/NULL to only query the count.
+ * @param max_count The number of entries out_stats can hold.
+ * @returns The number of callbacks with counters, which may exceed max_count.
+ */
+FAPI uint32_t event_stats_get_callbacks(event_callback_stats* out_stats, uint32_t max_count);
+
+// Zeroes all counters and starts a new window:
+FAPI void event_stats_reset();
+
+// Appends every active code and the most expensive callbacks of the current window:
+FAPI void event_stats_report(struct string_builder* builder);
+
+// How often event_stats_update logs the report and resets the counters. 0 disables the dump.
+FAPI void event_stats_set_dump_interval(float64_t seconds);
+
+// Dumps and resets the counters when the dump interval has passed. Called once per frame by the application.
+void event_stats_update();
+
 // System internal event codes. Application should use codes beyond 255.
 typedef enum system_event_code
 {
@@ -118,5 +302,21 @@ typedef enum system_event_code
      */
     EVENT_CODE_RESIZE = 0x08,
 
+    // An input action became active/inactive. Posted by the action mapping layer.
+    /*
+     * Context usage:
+     * input_action action = data.data.u16[0];
+     */
+    EVENT_CODE_ACTION_STARTED = 0x09,
+    EVENT_CODE_ACTION_ENDED = 0x0A,
+
+    // An input axis changed value.
+    /*
+     * Context usage:
+     * input_action axis = data.data.u16[0];
+     * float32_t value = data.data.f32[1];
+     */
+    EVENT_CODE_AXIS_CHANGED = 0x0B,
+
     MAX_EVENT_CODE = 0xFF
 } system_event_code;
\ No newline at end of file
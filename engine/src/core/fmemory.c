@@ -1,8 +1,6 @@
-#include "fmemory.h"
+#define LOG_CATEGORY LOG_CATEGORY_MEMORY
 
-// TODO: Custom string library.
-#include <string.h>
-#include <stdio.h>
+#include "fmemory.h"
 
 #include "core/fstring.h"
 #include "core/logger.h"
@@ -12,6 +10,8 @@ struct memory_stats
 {
     uint64_t total_allocated;
     uint64_t tagged_allocations[MEMORY_TAG_MAX_TAGS];
+    uint64_t tagged_budgets[MEMORY_TAG_MAX_TAGS];
+    memory_counters counters;
 };
 
 static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] =
@@ -21,6 +21,7 @@ static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] =
     "DARRAY     ",
     "DICT       ",
     "RING_QUEUE ",
+    "PRIO_QUEUE ",
     "BST        ",
     "STRING     ",
     "APPLICATION",
@@ -32,7 +33,8 @@ static const char* memory_tag_strings[MEMORY_TAG_MAX_TAGS] =
     "TRANSFORM  ",
     "ENTITY     ",
     "ENTITY_NODE",
-    "SCENE      "
+    "SCENE      ",
+    "EVENT      "
 };
 
 static struct memory_stats stats;
@@ -56,6 +58,8 @@ void* fallocate(uint64_t size, memory_tag tag)
 
     stats.total_allocated += size;
     stats.tagged_allocations[tag] += size;
+    stats.counters.allocation_count++;
+    stats.counters.bytes_allocated += size;
 
     // TODO: Will deal with mem alignment later.
     void* block = platform_allocate(size, FALSE);
@@ -72,6 +76,7 @@ void ffree(void* block, uint64_t size, memory_tag tag)
 
     stats.total_allocated -= size;
     stats.tagged_allocations[tag] -= size;
+    stats.counters.free_count++;
 
     // TODO: Will deal with mem alignment later.
     platform_free(block, FALSE);
@@ -79,61 +84,93 @@ void ffree(void* block, uint64_t size, memory_tag tag)
 
 void* fzero_memory(void* block, uint64_t size)
 {
+    stats.counters.bytes_set += size;
     return platform_zero_memory(block, size);
 }
 
 void* fcopy_memory(void* dest, const void* source, uint64_t size)
 {
+    stats.counters.bytes_copied += size;
     return platform_copy_memory(dest, source, size);
 }
 
 void* fset_memory(void* dest, int32_t value, uint64_t size)
 {
+    stats.counters.bytes_set += size;
     return platform_set_memory(dest, value, size);
 }
 
+void set_memory_tag_budget(memory_tag tag, uint64_t budget)
+{
+    stats.tagged_budgets[tag] = budget;
+}
+
+uint64_t get_memory_tag_budget(memory_tag tag)
+{
+    return stats.tagged_budgets[tag];
+}
+
+uint64_t get_memory_tag_usage(memory_tag tag)
+{
+    return stats.tagged_allocations[tag];
+}
+
+void get_memory_counters(memory_counters* out_counters)
+{
+    *out_counters = stats.counters;
+}
+
 // TODO: this is a debug function and needs improving.
-char* get_memory_usage_str()
+void get_memory_usage_report(string_builder* builder)
 {
     const uint64_t gib = 1024 * 1024 * 1024;
     const uint64_t mib = 1024 * 1024;
     const uint64_t kib = 1024;
 
-    char buffer[8000] = "System memory use (tagged):\n";
-    uint64_t offset = strlen(buffer);
+    string_builder_append(builder, "System memory use (tagged):\n");
 
     for (uint32_t i = 0; i < MEMORY_TAG_MAX_TAGS; ++i)
     {
-        char unit[4] = "XiB";
-        float amount = 1.0f;
+        const char* unit = "B";
+        float64_t amount = 1.0;
 
         if (stats.tagged_allocations[i] >= gib)
         {
-            unit[0] = 'G';
-            amount = stats.tagged_allocations[i] / (float)gib;
+            unit = "GiB";
+            amount = stats.tagged_allocations[i] / (float64_t)gib;
         }
         else if (stats.tagged_allocations[i] >= mib)
         {
-            unit[0] = 'M';
-            amount = stats.tagged_allocations[i] / (float)mib;
+            unit = "MiB";
+            amount = stats.tagged_allocations[i] / (float64_t)mib;
         }
         else if (stats.tagged_allocations[i] >= kib)
         {
-            unit[0] = 'K';
-            amount = stats.tagged_allocations[i] / (float)kib;
+            unit = "KiB";
+            amount = stats.tagged_allocations[i] / (float64_t)kib;
         }
         else
         {
-            unit[0] = 'B';
-            unit[1] = 0;
-            amount = (float)stats.tagged_allocations[i];
+            amount = (float64_t)stats.tagged_allocations[i];
         }
 
-        int32_t length = snprintf(buffer + offset, 8000, " %s: %.2f%s\n",
-            memory_tag_strings[i], amount, unit);
-        offset += length;
+        string_builder_append_char(builder, ' ');
+        string_builder_append(builder, memory_tag_strings[i]);
+        string_builder_append(builder, ": ");
+        string_builder_append_f64(builder, amount, 2);
+        string_builder_append(builder, unit);
+        string_builder_append_char(builder, '\n');
     }
+}
+
+char* get_memory_usage_str()
+{
+    char stack_buffer[2048];
+    string_builder builder;
+    string_builder_create_from_buffer(stack_buffer, sizeof(stack_buffer), 0, &builder);
+    get_memory_usage_report(&builder);
 
-    char* out_string = string_duplicate(buffer);
+    char* out_string = string_duplicate(string_builder_cstr(&builder));
+    string_builder_destroy(&builder);
     return out_string;
 }
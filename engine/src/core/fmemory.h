@@ -2,6 +2,8 @@
 
 #include "defines.h"
 
+struct string_builder;
+
 typedef enum memory_tag
 {
     MEMORY_TAG_UNKNOWN,
@@ -9,6 +11,7 @@ typedef enum memory_tag
     MEMORY_TAG_DARRAY,
     MEMORY_TAG_DICT,
     MEMORY_TAG_RING_QUEUE,
+    MEMORY_TAG_PRIORITY_QUEUE,
     MEMORY_TAG_BST,
     MEMORY_TAG_STRING,
     MEMORY_TAG_APPLICATION,
@@ -21,12 +24,23 @@ typedef enum memory_tag
     MEMORY_TAG_ENTITY,
     MEMORY_TAG_ENTITY_NODE,
     MEMORY_TAG_SCENE,
+    MEMORY_TAG_EVENT,
 
     MEMORY_TAG_MAX_TAGS
 } memory_tag;
 
-void initialize_memory();
-void shutdown_memory();
+// Running totals since initialize_memory. Only ever increase, so callers can diff two snapshots:
+typedef struct memory_counters
+{
+    uint64_t allocation_count;
+    uint64_t free_count;
+    uint64_t bytes_allocated;
+    uint64_t bytes_copied;
+    uint64_t bytes_set;
+} memory_counters;
+
+FAPI void initialize_memory();
+FAPI void shutdown_memory();
 
 FAPI void* fallocate(uint64_t size, memory_tag tag);
 
@@ -38,5 +52,18 @@ FAPI void* fcopy_memory(void* dest, const void* source, uint64_t size);
 
 FAPI void* fset_memory(void* dest, int32_t value, uint64_t size);
 
-// Debug-only console debug print memory usage:
+// Sets a soft byte budget for the given tag; 0 means unbounded. Budgets are not enforced by fallocate,
+// they are consulted by caches (see containers/lru_cache.h) to decide how much to keep resident:
+FAPI void set_memory_tag_budget(memory_tag tag, uint64_t budget);
+FAPI uint64_t get_memory_tag_budget(memory_tag tag);
+
+// Returns the amount of bytes currently allocated with the given tag:
+FAPI uint64_t get_memory_tag_usage(memory_tag tag);
+
+FAPI void get_memory_counters(memory_counters* out_counters);
+
+// Appends a per-tag memory usage report to the given builder:
+FAPI void get_memory_usage_report(struct string_builder* builder);
+
+// Debug-only console debug print memory usage. The returned string is owned by the caller:
 FAPI char* get_memory_usage_str();
\ No newline at end of file
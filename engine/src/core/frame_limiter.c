@@ -0,0 +1,113 @@
+#include "core/frame_limiter.h"
+
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#define FRAME_LIMITER_SAMPLES 512
+#define FRAME_LIMITER_REPORT_INTERVAL 10.0
+
+// Bounds of the calibrated sleep margin, in seconds:
+#define FRAME_LIMITER_MIN_MARGIN 0.0001
+#define FRAME_LIMITER_MAX_MARGIN 0.004
+#define FRAME_LIMITER_INITIAL_MARGIN 0.001
+// How much of the gap to an overshoot the margin gives back each frame:
+#define FRAME_LIMITER_MARGIN_DECAY 0.01
+
+void frame_limiter_create(float32_t target_frame_rate, frame_limiter* out_limiter)
+{
+    out_limiter->deadline = 0;
+    out_limiter->last_frame_end = 0;
+    out_limiter->sleep_margin = FRAME_LIMITER_INITIAL_MARGIN;
+    out_limiter->last_report = platform_get_absolute_time();
+    sample_window_create(FRAME_LIMITER_SAMPLES, &out_limiter->deviation);
+    frame_limiter_set_target(out_limiter, target_frame_rate);
+}
+
+void frame_limiter_destroy(frame_limiter* limiter)
+{
+    sample_window_destroy(&limiter->deviation);
+}
+
+void frame_limiter_set_target(frame_limiter* limiter, float32_t target_frame_rate)
+{
+    limiter->frame_seconds = target_frame_rate > 0 ? 1.0 / target_frame_rate : 0;
+    limiter->deadline = 0;
+    limiter->last_frame_end = 0;
+    sample_window_clear(&limiter->deviation);
+}
+
+static void frame_limiter_report(frame_limiter* limiter, float64_t now)
+{
+    if (now - limiter->last_report < FRAME_LIMITER_REPORT_INTERVAL || limiter->deviation.count == 0)
+    {
+        return;
+    }
+    limiter->last_report = now;
+
+    sample_summary jitter;
+    sample_window_summarize(&limiter->deviation, &jitter);
+    FINFO("Frame pacing jitter: p50 %.3fms, p99 %.3fms, max %.3fms, sleep margin %.3fms",
+        jitter.p50 * 1000.0, jitter.p99 * 1000.0, jitter.max * 1000.0, limiter->sleep_margin * 1000.0);
+}
+
+// Records how far the frame that just ended strayed from the target frame time. Measured between frame ends, so
+// overruns count as well as waits that ended late:
+static void frame_limiter_end_frame(frame_limiter* limiter, float64_t now)
+{
+    if (limiter->last_frame_end > 0)
+    {
+        float64_t deviation = now - limiter->last_frame_end - limiter->frame_seconds;
+        sample_window_add(&limiter->deviation, deviation < 0 ? -deviation : deviation);
+        frame_limiter_report(limiter, now);
+    }
+    limiter->last_frame_end = now;
+}
+
+void frame_limiter_wait(frame_limiter* limiter)
+{
+    if (limiter->frame_seconds <= 0)
+    {
+        return;
+    }
+
+    float64_t now = platform_get_absolute_time();
+    if (limiter->deadline == 0 || now >= limiter->deadline)
+    {
+        // First frame, or overran: schedule from now rather than bunching frames up to catch up:
+        limiter->deadline = now + limiter->frame_seconds;
+        frame_limiter_end_frame(limiter, now);
+        return;
+    }
+
+    float64_t wake_time = limiter->deadline - limiter->sleep_margin;
+    if (now < wake_time)
+    {
+        platform_sleep_until(wake_time);
+
+        // Calibrate: jump up to an overshoot that left too little margin, otherwise relax slowly towards it:
+        float64_t overshoot = platform_get_absolute_time() - wake_time;
+        float64_t wanted_margin = overshoot * 1.25;
+        if (wanted_margin > limiter->sleep_margin)
+        {
+            limiter->sleep_margin = wanted_margin;
+        }
+        else
+        {
+            limiter->sleep_margin += (wanted_margin - limiter->sleep_margin) * FRAME_LIMITER_MARGIN_DECAY;
+        }
+        limiter->sleep_margin = FCLAMP(limiter->sleep_margin, FRAME_LIMITER_MIN_MARGIN, FRAME_LIMITER_MAX_MARGIN);
+    }
+
+    while ((now = platform_get_absolute_time()) < limiter->deadline)
+    {
+        platform_cpu_relax();
+    }
+
+    frame_limiter_end_frame(limiter, now);
+    limiter->deadline += limiter->frame_seconds;
+}
+
+void frame_limiter_get_jitter(frame_limiter* limiter, sample_summary* out_summary)
+{
+    sample_window_summarize(&limiter->deviation, out_summary);
+}
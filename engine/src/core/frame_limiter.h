@@ -0,0 +1,44 @@
+#pragma once
+
+#include "defines.h"
+#include "core/metrics.h"
+
+/*
+ * Paces frames to a target rate. The OS wakes sleeping threads late by up to a millisecond or more, so the limiter
+ * sleeps until a margin before each deadline and spins out the rest. The margin is calibrated from how late sleeps
+ * actually wake up: it grows straight to any overshoot that ate into it and shrinks back slowly, trading a little
+ * CPU time for keeping deadlines.
+ */
+
+typedef struct frame_limiter
+{
+    // 0 if frames are not limited:
+    float64_t frame_seconds;
+    // When the current frame should end, on the platform_get_absolute_time clock:
+    float64_t deadline;
+    // How long before the deadline sleeping stops and spinning starts:
+    float64_t sleep_margin;
+    // When the previous frame ended, or 0:
+    float64_t last_frame_end;
+    // How far each frame's length strayed from frame_seconds, in seconds:
+    sample_window deviation;
+    float64_t last_report;
+} frame_limiter;
+
+/**
+ * Creates a limiter.
+ * @param target_frame_rate Frames per second to pace to, or 0 to not limit.
+ * @param out_limiter The limiter to initialize.
+ */
+void frame_limiter_create(float32_t target_frame_rate, frame_limiter* out_limiter);
+void frame_limiter_destroy(frame_limiter* limiter);
+
+// Changes the target rate, 0 to not limit. Takes effect from the next frame.
+void frame_limiter_set_target(frame_limiter* limiter, float32_t target_frame_rate);
+
+// Waits out the rest of the current frame. Frames that already overran their deadline start the next one right away
+// rather than trying to catch up.
+void frame_limiter_wait(frame_limiter* limiter);
+
+// Summarizes how far the length of recent frames strayed from the target, in seconds, overrunning frames included:
+void frame_limiter_get_jitter(frame_limiter* limiter, sample_summary* out_summary);
@@ -0,0 +1,254 @@
+#include "core/frame_stats.h"
+
+#include "core/fmemory.h"
+#include "core/fstring.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+// Samples kept per window, a bit over 8 seconds at 60 fps:
+#define FRAME_STATS_WINDOW 512
+#define FRAME_STATS_DEFAULT_DUMP_INTERVAL 10.0
+
+// Histogram from 0.1ms to ~1.6s, 16 buckets per octave:
+#define FRAME_STATS_HISTOGRAM_MIN 0.0001
+#define FRAME_STATS_HISTOGRAM_SUB_BUCKET_BITS 4
+#define FRAME_STATS_HISTOGRAM_OCTAVES 14
+
+static const char* frame_stat_names[FRAME_STAT_MAX] = {
+    "frame",
+    "update",
+    "render",
+    "idle"};
+
+typedef struct frame_stats_state
+{
+    sample_window windows[FRAME_STAT_MAX];
+    sample_histogram histograms[FRAME_STAT_MAX];
+    uint64_t frame_count;
+
+    float64_t dump_interval;
+    float64_t last_dump;
+
+    platform_file csv_file;
+    bool8_t csv_open;
+} frame_stats_state;
+
+static bool8_t initialized = FALSE;
+static frame_stats_state state;
+
+bool8_t frame_stats_initialize()
+{
+    if (initialized)
+    {
+        FERROR("frame_stats_initialize called more than once.");
+        return FALSE;
+    }
+
+    fzero_memory(&state, sizeof(frame_stats_state));
+    for (uint32_t i = 0; i < FRAME_STAT_MAX; ++i)
+    {
+        sample_window_create(FRAME_STATS_WINDOW, &state.windows[i]);
+        sample_histogram_create(FRAME_STATS_HISTOGRAM_MIN, FRAME_STATS_HISTOGRAM_SUB_BUCKET_BITS,
+            FRAME_STATS_HISTOGRAM_OCTAVES, &state.histograms[i]);
+    }
+    state.dump_interval = FRAME_STATS_DEFAULT_DUMP_INTERVAL;
+    state.last_dump = platform_get_absolute_time();
+
+    initialized = TRUE;
+    return TRUE;
+}
+
+void frame_stats_shutdown()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    frame_stats_set_csv_path(0);
+    for (uint32_t i = 0; i < FRAME_STAT_MAX; ++i)
+    {
+        sample_window_destroy(&state.windows[i]);
+        sample_histogram_destroy(&state.histograms[i]);
+    }
+    initialized = FALSE;
+}
+
+static void frame_stats_write_csv(float64_t now)
+{
+    char row_buffer[1024];
+    string_builder rows;
+    string_builder_create_from_buffer(row_buffer, sizeof(row_buffer), 0, &rows);
+    for (uint32_t i = 0; i < FRAME_STAT_MAX; ++i)
+    {
+        sample_summary summary;
+        sample_window_summarize(&state.windows[i], &summary);
+        string_builder_append_format(&rows, "%.3f,%llu,%s,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+            now, state.frame_count, frame_stat_names[i], summary.count, summary.min * 1000.0, summary.mean * 1000.0,
+            summary.p50 * 1000.0, summary.p95 * 1000.0, summary.p99 * 1000.0, summary.max * 1000.0);
+    }
+
+    if (!platform_file_write(&state.csv_file, string_builder_cstr(&rows), rows.length))
+    {
+        FERROR("Failed to write frame stats, closing the CSV file.");
+        frame_stats_set_csv_path(0);
+    }
+    string_builder_destroy(&rows);
+}
+
+static void frame_stats_dump(float64_t now)
+{
+    char report_buffer[4096];
+    string_builder report;
+    string_builder_create_from_buffer(report_buffer, sizeof(report_buffer), 0, &report);
+    frame_stats_report(&report);
+    FINFO("%s", string_builder_cstr(&report));
+    string_builder_destroy(&report);
+
+    if (state.csv_open)
+    {
+        frame_stats_write_csv(now);
+    }
+}
+
+void frame_stats_record(const float64_t times[FRAME_STAT_MAX])
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < FRAME_STAT_MAX; ++i)
+    {
+        sample_window_add(&state.windows[i], times[i]);
+        sample_histogram_add(&state.histograms[i], times[i]);
+    }
+    state.frame_count++;
+
+    if (state.dump_interval > 0)
+    {
+        float64_t now = platform_get_absolute_time();
+        if (now - state.last_dump >= state.dump_interval)
+        {
+            state.last_dump = now;
+            frame_stats_dump(now);
+        }
+    }
+}
+
+uint64_t frame_stats_frame_count()
+{
+    return state.frame_count;
+}
+
+void frame_stats_get(frame_stat stat, sample_summary* out_summary)
+{
+    if (!initialized || stat >= FRAME_STAT_MAX)
+    {
+        fzero_memory(out_summary, sizeof(sample_summary));
+        return;
+    }
+    sample_window_summarize(&state.windows[stat], out_summary);
+}
+
+const sample_histogram* frame_stats_get_histogram(frame_stat stat)
+{
+    if (!initialized || stat >= FRAME_STAT_MAX)
+    {
+        return 0;
+    }
+    return &state.histograms[stat];
+}
+
+void frame_stats_reset()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < FRAME_STAT_MAX; ++i)
+    {
+        sample_window_clear(&state.windows[i]);
+        sample_histogram_clear(&state.histograms[i]);
+    }
+}
+
+void frame_stats_report(string_builder* builder)
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    string_builder_append_format(builder, "Frame stats (%llu frames, last %u), ms:\n", state.frame_count,
+        state.windows[FRAME_STAT_FRAME].count);
+    for (uint32_t i = 0; i < FRAME_STAT_MAX; ++i)
+    {
+        sample_summary summary;
+        sample_window_summarize(&state.windows[i], &summary);
+        string_builder_append_format(builder,
+            "  %-6s min %7.3f  avg %7.3f  p50 %7.3f  p95 %7.3f  p99 %7.3f  max %7.3f\n", frame_stat_names[i],
+            summary.min * 1000.0, summary.mean * 1000.0, summary.p50 * 1000.0, summary.p95 * 1000.0,
+            summary.p99 * 1000.0, summary.max * 1000.0);
+    }
+
+    // Frame time histogram, non-empty buckets only:
+    const sample_histogram* histogram = &state.histograms[FRAME_STAT_FRAME];
+    if (histogram->total == 0)
+    {
+        return;
+    }
+
+    uint64_t largest = 0;
+    for (uint32_t i = 0; i < histogram->bucket_count; ++i)
+    {
+        largest = histogram->counts[i] > largest ? histogram->counts[i] : largest;
+    }
+
+    string_builder_append(builder, "  frame time histogram:\n");
+    for (uint32_t i = 0; i < histogram->bucket_count; ++i)
+    {
+        if (histogram->counts[i] == 0)
+        {
+            continue;
+        }
+
+        float64_t lower;
+        float64_t upper;
+        sample_histogram_bucket_bounds(histogram, i, &lower, &upper);
+        string_builder_append_format(builder, "  %8.3f - %8.3f %8llu ", lower * 1000.0, upper * 1000.0,
+            histogram->counts[i]);
+        string_builder_append_repeat(builder, '#', 1 + histogram->counts[i] * 39 / largest);
+        string_builder_append_char(builder, '\n');
+    }
+}
+
+void frame_stats_set_dump_interval(float64_t seconds)
+{
+    state.dump_interval = seconds;
+}
+
+bool8_t frame_stats_set_csv_path(const char* path)
+{
+    if (state.csv_open)
+    {
+        platform_file_close(&state.csv_file);
+        state.csv_open = FALSE;
+    }
+
+    if (!path)
+    {
+        return TRUE;
+    }
+
+    if (!platform_file_open(path, FALSE, &state.csv_file))
+    {
+        FERROR("Unable to open frame stats CSV file '%s'.", path);
+        return FALSE;
+    }
+    state.csv_open = TRUE;
+
+    const char* header = "time,frames,stat,count,min_ms,avg_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    return platform_file_write(&state.csv_file, header, string_length(header));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+#include "core/metrics.h"
+
+struct string_builder;
+
+/*
+ * Frame time statistics. The application records how long each frame took and how that split into updating,
+ * rendering and waiting for the frame limiter. Recent frames are kept in rolling windows for percentiles, and every
+ * frame since the last reset is counted in log-bucketed histograms. A summary is logged periodically and, if a CSV
+ * path is set (or FOO_FRAME_STATS_CSV is, at startup), appended to that file as well.
+ */
+
+typedef enum frame_stat
+{
+    // The whole frame, from the previous frame's start to this one's:
+    FRAME_STAT_FRAME,
+    // The game's update, all ticks of the frame:
+    FRAME_STAT_UPDATE,
+    // The game's render plus the renderer's frame:
+    FRAME_STAT_RENDER,
+    // Time given back by the frame limiter:
+    FRAME_STAT_IDLE,
+    FRAME_STAT_MAX
+} frame_stat;
+
+bool8_t frame_stats_initialize();
+void frame_stats_shutdown();
+
+/**
+ * Records one frame. Called by the application at the end of every frame.
+ * @param times The duration of each frame_stat, in seconds.
+ */
+void frame_stats_record(const float64_t times[FRAME_STAT_MAX]);
+
+// Frames recorded since initialization:
+FAPI uint64_t frame_stats_frame_count();
+
+// Summarizes the most recent frames, in seconds:
+FAPI void frame_stats_get(frame_stat stat, sample_summary* out_summary);
+
+// Gets the histogram of every frame since the last frame_stats_reset, in seconds:
+FAPI const sample_histogram* frame_stats_get_histogram(frame_stat stat);
+
+// Clears the windows and histograms:
+FAPI void frame_stats_reset();
+
+// Appends a human readable summary, with the frame time histogram, to builder:
+FAPI void frame_stats_report(struct string_builder* builder);
+
+// How often the summary is logged (and written to the CSV file). 0 disables the dump.
+FAPI void frame_stats_set_dump_interval(float64_t seconds);
+
+/**
+ * Starts appending a row per frame_stat to a CSV file on every dump. Replaces the file.
+ * @param path The file to write, or 0 to stop writing.
+ * @returns TRUE if the file could be created; otherwise FALSE.
+ */
+FAPI bool8_t frame_stats_set_csv_path(const char* path);
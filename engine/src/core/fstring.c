@@ -1,11 +1,74 @@
 #include "core/fstring.h"
 #include "core/fmemory.h"
+#include "core/arena.h"
+#include "core/logger.h"
+#include "containers/darray.h"
+#include "platform/platform.h"
 
 #include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
 
+// SSE2 is part of the x86-64 baseline. The vector extensions below compile to the same instructions as the
+// SSE2 intrinsics, without including <emmintrin.h> (which pulls in <stdlib.h> and its conflicting int typedefs).
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define FSTRING_SIMD 1
+typedef char fstring_vec16 __attribute__((vector_size(16), may_alias));
+typedef char fstring_vec16_unaligned __attribute__((vector_size(16), aligned(1), may_alias));
+#define FSTRING_MOVEMASK(vec) ((uint32_t)__builtin_ia32_pmovmskb128((fstring_vec16)(vec)))
+#else
+#define FSTRING_SIMD 0
+#endif
+
+#define STRING_INTERNER_ARENA_BLOCK_SIZE (64 * 1024)
+#define STRING_INTERNER_INITIAL_INDEX_CAPACITY 1024
+
+typedef struct string_interner_state
+{
+    // Backing storage for the interned characters:
+    arena storage;
+
+    // darray, indexed by id - 1:
+    string_view* entries;
+
+    // Open-addressing hash index of ids, 0 marks an empty slot:
+    string_id* index;
+    uint32_t index_capacity;
+} string_interner_state;
+
+static bool8_t interner_initialized = FALSE;
+static string_interner_state interner;
+
+#if FSTRING_SIMD
+// Aligned 16-byte loads never cross a page boundary, so reading the rest of the block that holds the
+// terminator is safe, but address sanitizer cannot know that:
+__attribute__((no_sanitize("address")))
+#endif
 uint64_t string_length(const char* str)
 {
+#if FSTRING_SIMD
+    const fstring_vec16 zero = {0};
+    const char* block = (const char*)((uint64_t)str & ~(uint64_t)15);
+
+    // Discard matches for the bytes in the first block that come before str:
+    uint32_t mask = FSTRING_MOVEMASK(*(const fstring_vec16*)block == zero) >> ((uint64_t)str & 15);
+    if (mask)
+    {
+        return __builtin_ctz(mask);
+    }
+
+    for (;;)
+    {
+        block += 16;
+        mask = FSTRING_MOVEMASK(*(const fstring_vec16*)block == zero);
+        if (mask)
+        {
+            return (uint64_t)(block - str) + __builtin_ctz(mask);
+        }
+    }
+#else
     return strlen(str);
+#endif
 }
 
 char* string_duplicate(const char* str)
@@ -20,3 +83,848 @@ bool8_t strings_equal(const char* str0, const char* str1)
 {
     return strcmp(str0, str1) == 0;
 }
+
+string_view string_view_create(const char* str)
+{
+    return string_view_from(str, string_length(str));
+}
+
+string_view string_view_from(const char* str, uint64_t length)
+{
+    string_view view;
+    view.str = str;
+    view.length = length;
+    view.hash = string_hash(str, length);
+    return view;
+}
+
+uint32_t string_hash(const char* str, uint64_t length)
+{
+    // Word-at-a-time multiplicative hash, consuming 8 bytes per step:
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ length;
+    while (length >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, str, 8);
+        hash ^= word * 0xFF51AFD7ED558CCDull;
+        hash = ((hash << 29) | (hash >> 35)) * 0xC4CEB9FE1A85EC53ull;
+        str += 8;
+        length -= 8;
+    }
+
+    if (length)
+    {
+        uint64_t word = 0;
+        memcpy(&word, str, length);
+        hash ^= word * 0xFF51AFD7ED558CCDull;
+        hash = ((hash << 29) | (hash >> 35)) * 0xC4CEB9FE1A85EC53ull;
+    }
+
+    // Avalanche so every input bit affects the low 32 bits:
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return (uint32_t)hash;
+}
+
+bool8_t string_bytes_equal(const char* a, const char* b, uint64_t length)
+{
+#if FSTRING_SIMD
+    while (length >= 16)
+    {
+        fstring_vec16_unaligned va = *(const fstring_vec16_unaligned*)a;
+        fstring_vec16_unaligned vb = *(const fstring_vec16_unaligned*)b;
+        if (FSTRING_MOVEMASK(va == vb) != 0xFFFF)
+        {
+            return FALSE;
+        }
+        a += 16;
+        b += 16;
+        length -= 16;
+    }
+#endif
+    return memcmp(a, b, length) == 0;
+}
+
+bool8_t string_views_equal(string_view a, string_view b)
+{
+    if (a.length != b.length || a.hash != b.hash)
+    {
+        return FALSE;
+    }
+    return a.str == b.str || string_bytes_equal(a.str, b.str, a.length);
+}
+
+int64_t string_view_find(string_view haystack, string_view needle)
+{
+    if (needle.length == 0)
+    {
+        return 0;
+    }
+
+    if (needle.length > haystack.length)
+    {
+        return -1;
+    }
+
+    // Last offset at which the needle still fits:
+    uint64_t last = haystack.length - needle.length;
+    char first = needle.str[0];
+    uint64_t i = 0;
+
+#if FSTRING_SIMD
+    // Scan for the first needle character 16 candidates at a time, verifying only the hits:
+    fstring_vec16_unaligned first_vec = (fstring_vec16_unaligned){0} + first;
+    for (; i + 16 <= last + 1; i += 16)
+    {
+        fstring_vec16_unaligned block = *(const fstring_vec16_unaligned*)(haystack.str + i);
+        uint32_t mask = FSTRING_MOVEMASK(block == first_vec);
+        while (mask)
+        {
+            uint64_t offset = i + __builtin_ctz(mask);
+            if (string_bytes_equal(haystack.str + offset + 1, needle.str + 1, needle.length - 1))
+            {
+                return (int64_t)offset;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i <= last; ++i)
+    {
+        if (haystack.str[i] == first &&
+            string_bytes_equal(haystack.str + i + 1, needle.str + 1, needle.length - 1))
+        {
+            return (int64_t)i;
+        }
+    }
+
+    return -1;
+}
+
+// Returns the slot holding the view, or the empty slot where it would go:
+static uint32_t string_interner_find_slot(string_view view)
+{
+    uint32_t mask = interner.index_capacity - 1;
+    uint32_t slot = view.hash & mask;
+    while (interner.index[slot] != INVALID_STRING_ID)
+    {
+        if (string_views_equal(interner.entries[interner.index[slot] - 1], view))
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void string_interner_grow_index()
+{
+    string_id* old_index = interner.index;
+    uint32_t old_capacity = interner.index_capacity;
+
+    interner.index_capacity = old_capacity * 2;
+    interner.index = fallocate(sizeof(string_id) * interner.index_capacity, MEMORY_TAG_STRING);
+
+    uint32_t mask = interner.index_capacity - 1;
+    for (uint32_t i = 0; i < old_capacity; ++i)
+    {
+        string_id id = old_index[i];
+        if (id == INVALID_STRING_ID)
+        {
+            continue;
+        }
+
+        uint32_t slot = interner.entries[id - 1].hash & mask;
+        while (interner.index[slot] != INVALID_STRING_ID)
+        {
+            slot = (slot + 1) & mask;
+        }
+        interner.index[slot] = id;
+    }
+
+    ffree(old_index, sizeof(string_id) * old_capacity, MEMORY_TAG_STRING);
+}
+
+bool8_t string_interner_initialize()
+{
+    if (interner_initialized)
+    {
+        return FALSE;
+    }
+
+    arena_create(STRING_INTERNER_ARENA_BLOCK_SIZE, MEMORY_TAG_STRING, &interner.storage);
+    interner.entries = darray_create(string_view);
+    interner.index_capacity = STRING_INTERNER_INITIAL_INDEX_CAPACITY;
+    interner.index = fallocate(sizeof(string_id) * interner.index_capacity, MEMORY_TAG_STRING);
+    interner_initialized = TRUE;
+    return TRUE;
+}
+
+void string_interner_shutdown()
+{
+    if (!interner_initialized)
+    {
+        return;
+    }
+
+    ffree(interner.index, sizeof(string_id) * interner.index_capacity, MEMORY_TAG_STRING);
+    darray_destroy(interner.entries);
+    arena_destroy(&interner.storage);
+    fzero_memory(&interner, sizeof(interner));
+    interner_initialized = FALSE;
+}
+
+string_id string_intern(const char* str)
+{
+    return string_intern_view(string_view_create(str));
+}
+
+string_id string_intern_view(string_view view)
+{
+    if (!interner_initialized)
+    {
+        FERROR("string_intern called before string_interner_initialize.");
+        return INVALID_STRING_ID;
+    }
+
+    uint32_t slot = string_interner_find_slot(view);
+    if (interner.index[slot] != INVALID_STRING_ID)
+    {
+        return interner.index[slot];
+    }
+
+    // Keep the index at most half full:
+    uint64_t count = darray_length(interner.entries);
+    if ((count + 1) * 2 > interner.index_capacity)
+    {
+        string_interner_grow_index();
+        slot = string_interner_find_slot(view);
+    }
+
+    char* copy = arena_allocate(&interner.storage, view.length + 1);
+    fcopy_memory(copy, view.str, view.length);
+    copy[view.length] = 0;
+
+    string_view stored = view;
+    stored.str = copy;
+    darray_push(interner.entries, stored);
+
+    string_id id = (string_id)(count + 1);
+    interner.index[slot] = id;
+    return id;
+}
+
+string_id string_id_find(string_view view)
+{
+    if (!interner_initialized)
+    {
+        return INVALID_STRING_ID;
+    }
+    return interner.index[string_interner_find_slot(view)];
+}
+
+const char* string_id_str(string_id id)
+{
+    if (!interner_initialized || id == INVALID_STRING_ID || id > darray_length(interner.entries))
+    {
+        return 0;
+    }
+    return interner.entries[id - 1].str;
+}
+
+string_view string_id_view(string_id id)
+{
+    if (!interner_initialized || id == INVALID_STRING_ID || id > darray_length(interner.entries))
+    {
+        string_view empty = {0};
+        return empty;
+    }
+    return interner.entries[id - 1];
+}
+
+// -- String builder --
+
+#define STRING_BUILDER_DEFAULT_CAPACITY 256
+// Enough for any 64-bit integer in any base >= 2 plus sign, or a fixed-point float up to the fallback limit:
+#define STRING_FORMAT_SCRATCH_SIZE 72
+// Largest precision the fixed-point float formatter handles; beyond this snprintf is used:
+#define STRING_FORMAT_MAX_FAST_DECIMALS 9
+
+static const uint64_t powers_of_ten[STRING_FORMAT_MAX_FAST_DECIMALS + 1] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull
+};
+
+static void string_builder_reserve(string_builder* builder, uint64_t additional)
+{
+    uint64_t required = builder->length + additional;
+    if (required <= builder->capacity)
+    {
+        return;
+    }
+
+    uint64_t new_capacity = builder->capacity ? builder->capacity * 2 : STRING_BUILDER_DEFAULT_CAPACITY;
+    while (new_capacity < required)
+    {
+        new_capacity *= 2;
+    }
+
+    // The most recent arena allocation can often simply be extended in place:
+    if (builder->arena && builder->buffer && !builder->owns_buffer &&
+        arena_extend(builder->arena, builder->buffer, builder->capacity + 1, new_capacity + 1))
+    {
+        builder->capacity = new_capacity;
+        return;
+    }
+
+    // N.B: Not through fallocate, the logger grows builders on any thread and the memory counters are only safe to
+    // touch from the main thread:
+    char* new_buffer = builder->arena
+        ? arena_allocate(builder->arena, new_capacity + 1)
+        : platform_allocate(new_capacity + 1, FALSE);
+    if (builder->length)
+    {
+        platform_copy_memory(new_buffer, builder->buffer, builder->length);
+    }
+
+    if (builder->owns_buffer)
+    {
+        platform_free(builder->buffer, FALSE);
+    }
+
+    builder->buffer = new_buffer;
+    builder->capacity = new_capacity;
+    builder->owns_buffer = builder->arena == 0;
+}
+
+// Appends go straight to the platform layer: the logger formats on any thread, and fcopy_memory/fset_memory
+// update the (single-threaded) memory counters.
+static void string_builder_append_bytes(string_builder* builder, const char* bytes, uint64_t length)
+{
+    string_builder_reserve(builder, length);
+    platform_copy_memory(builder->buffer + builder->length, bytes, length);
+    builder->length += length;
+}
+
+// Writes value in the given base into the end of scratch, returning the start of the digits:
+static char* format_u64_digits(char* scratch_end, uint64_t value, uint32_t base, bool8_t uppercase)
+{
+    const char* digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+    char* cursor = scratch_end;
+    do
+    {
+        *--cursor = digits[value % base];
+        value /= base;
+    } while (value);
+    return cursor;
+}
+
+// Returns the exact rounding error of product = a * b (Dekker's product), without needing an FMA:
+static float64_t product_error(float64_t a, float64_t b, float64_t product)
+{
+    const float64_t split = 134217729.0; // 2^27 + 1
+    float64_t a_split = split * a;
+    float64_t a_high = a_split - (a_split - a);
+    float64_t a_low = a - a_high;
+    float64_t b_split = split * b;
+    float64_t b_high = b_split - (b_split - b);
+    float64_t b_low = b - b_high;
+    return (((a_high * b_high) - product) + (a_high * b_low) + (a_low * b_high)) + (a_low * b_low);
+}
+
+/**
+ * Formats a float with a fixed amount of decimals into scratch.
+ * @returns The amount of characters written, or 0 if the value is outside what fixed-point formatting
+ * can represent exactly enough, in which case the caller should fall back to snprintf.
+ */
+static uint64_t format_f64_fixed(char* scratch, float64_t value, uint32_t decimals)
+{
+    char* cursor = scratch;
+    if (value != value)
+    {
+        platform_copy_memory(cursor, "nan", 3);
+        return 3;
+    }
+
+    if (value < 0 || (value == 0 && 1.0 / value < 0))
+    {
+        *cursor++ = '-';
+        value = -value;
+    }
+
+    if (value > 1.7976931348623157e308)
+    {
+        platform_copy_memory(cursor, "inf", 3);
+        return (uint64_t)(cursor - scratch) + 3;
+    }
+
+    // The scaled value must stay below 2^53, where doubles still hold every integer. Above that the product is
+    // already rounded to a multiple of 2 or more before its digits are extracted:
+    if (decimals > STRING_FORMAT_MAX_FAST_DECIMALS || value >= 9007199254740992.0 / (float64_t)powers_of_ten[decimals])
+    {
+        return 0;
+    }
+
+    uint64_t scale = powers_of_ten[decimals];
+    float64_t scaled_value = value * (float64_t)scale;
+    uint64_t scaled = (uint64_t)scaled_value;
+
+    // Round to nearest like printf. A remainder of exactly 0.5 may be the product rounding onto the tie, so the
+    // exact rounding error of the product decides, and only true ties go to even:
+    float64_t remainder = scaled_value - (float64_t)scaled;
+    if (remainder > 0.5)
+    {
+        scaled++;
+    }
+    else if (remainder == 0.5)
+    {
+        float64_t error = product_error(value, (float64_t)scale, scaled_value);
+        if (error > 0 || (error == 0 && (scaled & 1)))
+        {
+            scaled++;
+        }
+    }
+    uint64_t integer_part = scaled / scale;
+    uint64_t fraction_part = scaled % scale;
+
+    char digits[STRING_FORMAT_SCRATCH_SIZE];
+    char* end = digits + sizeof(digits);
+    char* start = format_u64_digits(end, integer_part, 10, FALSE);
+    platform_copy_memory(cursor, start, (uint64_t)(end - start));
+    cursor += end - start;
+
+    if (decimals)
+    {
+        *cursor++ = '.';
+        for (uint32_t i = decimals; i > 0; --i)
+        {
+            cursor[i - 1] = (char)('0' + (fraction_part % 10));
+            fraction_part /= 10;
+        }
+        cursor += decimals;
+    }
+
+    return (uint64_t)(cursor - scratch);
+}
+
+// Formats a single floating point conversion the builder does not handle itself through snprintf:
+static void string_builder_append_float_snprintf(string_builder* builder, char conversion, bool8_t left_align,
+    bool8_t zero_pad, bool8_t force_sign, int32_t width, int32_t precision, float64_t value)
+{
+    char spec[16];
+    uint32_t i = 0;
+    spec[i++] = '%';
+    if (left_align) { spec[i++] = '-'; }
+    if (zero_pad) { spec[i++] = '0'; }
+    if (force_sign) { spec[i++] = '+'; }
+    spec[i++] = '*';
+    if (precision >= 0)
+    {
+        spec[i++] = '.';
+        spec[i++] = '*';
+    }
+    spec[i++] = conversion;
+    spec[i] = 0;
+
+    string_builder_reserve(builder, STRING_FORMAT_SCRATCH_SIZE);
+    for (uint32_t attempt = 0; attempt < 2; ++attempt)
+    {
+        uint64_t available = builder->capacity - builder->length + 1;
+        char* dest = builder->buffer + builder->length;
+        int32_t written = precision >= 0
+            ? snprintf(dest, available, spec, width, precision, value)
+            : snprintf(dest, available, spec, width, value);
+        if (written < 0)
+        {
+            return;
+        }
+        if ((uint64_t)written < available)
+        {
+            builder->length += (uint64_t)written;
+            return;
+        }
+        string_builder_reserve(builder, (uint64_t)written);
+    }
+}
+
+void string_builder_create(struct arena* arena, uint64_t capacity, string_builder* out_builder)
+{
+    out_builder->buffer = 0;
+    out_builder->length = 0;
+    out_builder->capacity = 0;
+    out_builder->arena = arena;
+    out_builder->owns_buffer = FALSE;
+    string_builder_reserve(out_builder, capacity ? capacity : STRING_BUILDER_DEFAULT_CAPACITY);
+}
+
+void string_builder_create_from_buffer(char* buffer, uint64_t size, struct arena* arena,
+    string_builder* out_builder)
+{
+    out_builder->buffer = buffer;
+    out_builder->length = 0;
+    out_builder->capacity = size ? size - 1 : 0;
+    out_builder->arena = arena;
+    out_builder->owns_buffer = FALSE;
+}
+
+void string_builder_destroy(string_builder* builder)
+{
+    if (builder->owns_buffer)
+    {
+        platform_free(builder->buffer, FALSE);
+    }
+
+    builder->buffer = 0;
+    builder->length = 0;
+    builder->capacity = 0;
+    builder->owns_buffer = FALSE;
+}
+
+void string_builder_clear(string_builder* builder)
+{
+    builder->length = 0;
+}
+
+void string_builder_append(string_builder* builder, const char* str)
+{
+    string_builder_append_bytes(builder, str, string_length(str));
+}
+
+void string_builder_append_view(string_builder* builder, string_view view)
+{
+    string_builder_append_bytes(builder, view.str, view.length);
+}
+
+void string_builder_append_char(string_builder* builder, char c)
+{
+    string_builder_reserve(builder, 1);
+    builder->buffer[builder->length++] = c;
+}
+
+void string_builder_append_repeat(string_builder* builder, char c, uint64_t count)
+{
+    string_builder_reserve(builder, count);
+    platform_set_memory(builder->buffer + builder->length, c, count);
+    builder->length += count;
+}
+
+void string_builder_append_u64(string_builder* builder, uint64_t value)
+{
+    char scratch[STRING_FORMAT_SCRATCH_SIZE];
+    char* end = scratch + sizeof(scratch);
+    char* start = format_u64_digits(end, value, 10, FALSE);
+    string_builder_append_bytes(builder, start, (uint64_t)(end - start));
+}
+
+void string_builder_append_i64(string_builder* builder, int64_t value)
+{
+    if (value < 0)
+    {
+        string_builder_append_char(builder, '-');
+        // Negate in unsigned space so INT64_MIN does not overflow:
+        string_builder_append_u64(builder, 0 - (uint64_t)value);
+        return;
+    }
+    string_builder_append_u64(builder, (uint64_t)value);
+}
+
+void string_builder_append_f64(string_builder* builder, float64_t value, uint32_t decimals)
+{
+    char scratch[STRING_FORMAT_SCRATCH_SIZE];
+    uint64_t length = format_f64_fixed(scratch, value, decimals);
+    if (length == 0)
+    {
+        string_builder_append_float_snprintf(builder, 'f', FALSE, FALSE, FALSE, 0, (int32_t)decimals, value);
+        return;
+    }
+    string_builder_append_bytes(builder, scratch, length);
+}
+
+void string_builder_append_format(string_builder* builder, const char* format, ...)
+{
+    __builtin_va_list arg_ptr;
+    va_start(arg_ptr, format);
+    string_builder_append_format_v(builder, format, arg_ptr);
+    va_end(arg_ptr);
+}
+
+// Appends a formatted item, padded to width:
+static void string_builder_append_padded(string_builder* builder, const char* item, uint64_t length, int32_t width,
+    bool8_t left_align, bool8_t zero_pad)
+{
+    uint64_t padding = (width > 0 && (uint64_t)width > length) ? (uint64_t)width - length : 0;
+    if (padding == 0)
+    {
+        string_builder_append_bytes(builder, item, length);
+        return;
+    }
+
+    if (left_align)
+    {
+        string_builder_append_bytes(builder, item, length);
+        string_builder_append_repeat(builder, ' ', padding);
+        return;
+    }
+
+    if (zero_pad)
+    {
+        // Zeros go between the sign and the digits:
+        if (length && (item[0] == '-' || item[0] == '+'))
+        {
+            string_builder_append_char(builder, item[0]);
+            item++;
+            length--;
+        }
+        string_builder_append_repeat(builder, '0', padding);
+    }
+    else
+    {
+        string_builder_append_repeat(builder, ' ', padding);
+    }
+    string_builder_append_bytes(builder, item, length);
+}
+
+void string_builder_append_format_v(string_builder* builder, const char* format, __builtin_va_list args)
+{
+    // Copy so that callers can keep using their own list, as with vsnprintf:
+    __builtin_va_list arg_ptr;
+    va_copy(arg_ptr, args);
+
+    const char* cursor = format;
+    while (*cursor)
+    {
+        // Copy literal runs in one go:
+        const char* literal_start = cursor;
+        while (*cursor && *cursor != '%')
+        {
+            cursor++;
+        }
+        if (cursor != literal_start)
+        {
+            string_builder_append_bytes(builder, literal_start, (uint64_t)(cursor - literal_start));
+        }
+        if (!*cursor)
+        {
+            break;
+        }
+
+        const char* spec_start = cursor++;
+
+        // Flags:
+        bool8_t left_align = FALSE;
+        bool8_t zero_pad = FALSE;
+        bool8_t force_sign = FALSE;
+        for (;; cursor++)
+        {
+            if (*cursor == '-') { left_align = TRUE; }
+            else if (*cursor == '0') { zero_pad = TRUE; }
+            else if (*cursor == '+') { force_sign = TRUE; }
+            else if (*cursor != ' ' && *cursor != '#') { break; }
+        }
+
+        // Width:
+        int32_t width = 0;
+        if (*cursor == '*')
+        {
+            width = va_arg(arg_ptr, int32_t);
+            if (width < 0)
+            {
+                left_align = TRUE;
+                width = -width;
+            }
+            cursor++;
+        }
+        while (*cursor >= '0' && *cursor <= '9')
+        {
+            width = (width * 10) + (*cursor++ - '0');
+        }
+
+        // Precision:
+        int32_t precision = -1;
+        if (*cursor == '.')
+        {
+            cursor++;
+            precision = 0;
+            if (*cursor == '*')
+            {
+                precision = va_arg(arg_ptr, int32_t);
+                cursor++;
+            }
+            while (*cursor >= '0' && *cursor <= '9')
+            {
+                precision = (precision * 10) + (*cursor++ - '0');
+            }
+        }
+
+        // Length modifiers. Anything wider than int is read as 64 bits. A single 'l' is long, which is only 32 bits
+        // on LLP64 targets (Win64); z/t follow the pointer size:
+        bool8_t is_64bit = FALSE;
+        bool8_t is_long_double = FALSE;
+        uint32_t short_count = 0;
+        uint32_t long_count = 0;
+        while (*cursor == 'h' || *cursor == 'l' || *cursor == 'z' || *cursor == 'j' || *cursor == 't' ||
+            *cursor == 'L')
+        {
+            if (*cursor == 'h')
+            {
+                short_count++;
+            }
+            else if (*cursor == 'l')
+            {
+                long_count++;
+            }
+            else if (*cursor == 'L')
+            {
+                is_long_double = TRUE;
+            }
+            else if (*cursor == 'j' || sizeof(void*) == 8)
+            {
+                is_64bit = TRUE;
+            }
+            cursor++;
+        }
+        if (long_count >= 2 || (long_count == 1 && sizeof(long) == 8))
+        {
+            is_64bit = TRUE;
+        }
+
+        char conversion = *cursor;
+        if (!conversion)
+        {
+            break;
+        }
+        cursor++;
+
+        char scratch[STRING_FORMAT_SCRATCH_SIZE];
+        char* scratch_end = scratch + sizeof(scratch);
+        switch (conversion)
+        {
+            case '%':
+                string_builder_append_char(builder, '%');
+                break;
+            case 'c':
+            {
+                char c = (char)va_arg(arg_ptr, int32_t);
+                string_builder_append_padded(builder, &c, 1, width, left_align, FALSE);
+            }
+            break;
+            case 's':
+            {
+                const char* str = va_arg(arg_ptr, const char*);
+                if (!str)
+                {
+                    str = "(null)";
+                }
+                uint64_t length = string_length(str);
+                if (precision >= 0 && (uint64_t)precision < length)
+                {
+                    length = (uint64_t)precision;
+                }
+                string_builder_append_padded(builder, str, length, width, left_align, FALSE);
+            }
+            break;
+            case 'd':
+            case 'i':
+            {
+                int64_t value = is_64bit ? va_arg(arg_ptr, int64_t) : (int64_t)va_arg(arg_ptr, int32_t);
+                if (short_count)
+                {
+                    value = short_count == 1 ? (int64_t)(int16_t)value : (int64_t)(int8_t)value;
+                }
+                uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+                char* start = format_u64_digits(scratch_end, magnitude, 10, FALSE);
+                if (value < 0)
+                {
+                    *--start = '-';
+                }
+                else if (force_sign)
+                {
+                    *--start = '+';
+                }
+                string_builder_append_padded(builder, start, (uint64_t)(scratch_end - start), width, left_align,
+                    zero_pad);
+            }
+            break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            {
+                uint64_t value = is_64bit ? va_arg(arg_ptr, uint64_t) : (uint64_t)va_arg(arg_ptr, uint32_t);
+                if (short_count)
+                {
+                    value = short_count == 1 ? (uint64_t)(uint16_t)value : (uint64_t)(uint8_t)value;
+                }
+                uint32_t base = conversion == 'u' ? 10 : (conversion == 'o' ? 8 : 16);
+                char* start = format_u64_digits(scratch_end, value, base, conversion == 'X');
+                string_builder_append_padded(builder, start, (uint64_t)(scratch_end - start), width, left_align,
+                    zero_pad);
+            }
+            break;
+            case 'p':
+            {
+                uint64_t value = (uint64_t)va_arg(arg_ptr, void*);
+                char* start = format_u64_digits(scratch_end, value, 16, FALSE);
+                *--start = 'x';
+                *--start = '0';
+                string_builder_append_padded(builder, start, (uint64_t)(scratch_end - start), width, left_align,
+                    FALSE);
+            }
+            break;
+            case 'f':
+            case 'F':
+            {
+                float64_t value = is_long_double ? (float64_t)va_arg(arg_ptr, long double) : va_arg(arg_ptr, float64_t);
+                uint32_t decimals = precision < 0 ? 6 : (uint32_t)precision;
+                char* start = scratch + 1;
+                uint64_t length = format_f64_fixed(start, value, decimals);
+                if (length == 0)
+                {
+                    string_builder_append_float_snprintf(builder, conversion, left_align, zero_pad, force_sign, width,
+                        (int32_t)decimals, value);
+                    break;
+                }
+                if (force_sign && start[0] != '-')
+                {
+                    *--start = '+';
+                    length++;
+                }
+                string_builder_append_padded(builder, start, length, width, left_align, zero_pad);
+            }
+            break;
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+            {
+                float64_t value = is_long_double ? (float64_t)va_arg(arg_ptr, long double) : va_arg(arg_ptr, float64_t);
+                string_builder_append_float_snprintf(builder, conversion, left_align, zero_pad, force_sign, width,
+                    precision, value);
+            }
+            break;
+            case 'n':
+                // Not supported; consume the pointer:
+                va_arg(arg_ptr, void*);
+                break;
+            default:
+                // Unknown conversion, output it verbatim:
+                string_builder_append_bytes(builder, spec_start, (uint64_t)(cursor - spec_start));
+                break;
+        }
+    }
+
+    va_end(arg_ptr);
+}
+
+const char* string_builder_cstr(const string_builder* builder)
+{
+    if (!builder->buffer)
+    {
+        return "";
+    }
+    builder->buffer[builder->length] = 0;
+    return builder->buffer;
+}
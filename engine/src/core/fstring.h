@@ -7,4 +7,108 @@ FAPI uint64_t string_length(const char* str);
 FAPI char* string_duplicate(const char* str);
 
 // Case-sensitive comparison. True if same, false if not.
-FAPI bool8_t strings_equal(const char* str0, const char* str1);
\ No newline at end of file
+FAPI bool8_t strings_equal(const char* str0, const char* str1);
+
+/*
+ * Non-owning, length-prefixed view into a string, with its hash computed once up front.
+ * Comparing two views checks length and hash before touching any bytes, so matching one name against a
+ * list of candidates only scans the candidates whose length and hash already match.
+ * N.B: The viewed string must outlive the view and is not required to be null-terminated.
+ */
+typedef struct string_view
+{
+    const char* str;
+    uint64_t length;
+    uint32_t hash;
+} string_view;
+
+// Creates a view over a null-terminated string, computing its length and hash:
+FAPI string_view string_view_create(const char* str);
+
+// Creates a view over the first length bytes of str, computing its hash:
+FAPI string_view string_view_from(const char* str, uint64_t length);
+
+// Hashes length bytes of str. Stable across runs, so hashes may be persisted:
+FAPI uint32_t string_hash(const char* str, uint64_t length);
+
+// Case-sensitive comparison. Compares length and hash first, then bytes.
+FAPI bool8_t string_views_equal(string_view a, string_view b);
+
+// Case-sensitive comparison of length bytes. True if same, false if not.
+FAPI bool8_t string_bytes_equal(const char* a, const char* b, uint64_t length);
+
+/**
+ * Finds the first occurrence of needle in haystack.
+ * @returns The byte offset of the match, or -1 if not found. An empty needle matches at 0.
+ */
+FAPI int64_t string_view_find(string_view haystack, string_view needle);
+
+// -- String interning --
+// Interned strings are stored once, in an arena, for the lifetime of the interner and are identified by a
+// stable 32-bit id, so names can be compared and used as map keys as plain integers. Main thread only.
+
+typedef uint32_t string_id;
+
+#define INVALID_STRING_ID 0
+
+bool8_t string_interner_initialize();
+void string_interner_shutdown();
+
+// Returns the id of the given string, interning a copy of it if it was not interned before:
+FAPI string_id string_intern(const char* str);
+FAPI string_id string_intern_view(string_view view);
+
+// Returns the id of an already interned string without interning it, or INVALID_STRING_ID:
+FAPI string_id string_id_find(string_view view);
+
+// Returns the interned, null-terminated string for an id, or 0 for INVALID_STRING_ID/unknown ids:
+FAPI const char* string_id_str(string_id id);
+FAPI string_view string_id_view(string_id id);
+
+// -- String builder --
+// Appends into a growable buffer. The buffer can start out in caller-provided memory (e.g. on the stack) and
+// grows into an arena when one is given, or through fallocate otherwise. Number formatting is done by the
+// builder itself rather than printf, so it is locale independent and does not parse a format string.
+
+typedef struct string_builder
+{
+    char* buffer;
+    uint64_t length;
+    // Excludes the null terminator, which is always reserved:
+    uint64_t capacity;
+    // Where to grow into. If 0, growth goes through platform_allocate, which is safe from any thread, and
+    // string_builder_destroy frees it:
+    struct arena* arena;
+    bool8_t owns_buffer;
+} string_builder;
+
+// Creates a builder with an initial capacity allocated from arena, or through platform_allocate if arena is 0:
+FAPI void string_builder_create(struct arena* arena, uint64_t capacity, string_builder* out_builder);
+
+// Creates a builder that starts out writing into buffer (size bytes, including the null terminator):
+FAPI void string_builder_create_from_buffer(char* buffer, uint64_t size, struct arena* arena,
+    string_builder* out_builder);
+
+// Frees the buffer if it was allocated through platform_allocate. Arena memory is released with the arena.
+FAPI void string_builder_destroy(string_builder* builder);
+
+FAPI void string_builder_clear(string_builder* builder);
+
+FAPI void string_builder_append(string_builder* builder, const char* str);
+FAPI void string_builder_append_view(string_builder* builder, string_view view);
+FAPI void string_builder_append_char(string_builder* builder, char c);
+FAPI void string_builder_append_repeat(string_builder* builder, char c, uint64_t count);
+FAPI void string_builder_append_u64(string_builder* builder, uint64_t value);
+FAPI void string_builder_append_i64(string_builder* builder, int64_t value);
+FAPI void string_builder_append_f64(string_builder* builder, float64_t value, uint32_t decimals);
+
+/**
+ * Appends printf-style formatted text. d/i/u/x/X/o/c/s/p/f/F conversions, flags '-', '0', '+', width,
+ * precision and length modifiers are handled by the builder's own formatters; e/E/g/G/a/A fall back to
+ * snprintf for that single conversion.
+ */
+FAPI void string_builder_append_format(string_builder* builder, const char* format, ...);
+FAPI void string_builder_append_format_v(string_builder* builder, const char* format, __builtin_va_list args);
+
+// Returns the null-terminated contents. Valid until the next append or until the builder is destroyed.
+FAPI const char* string_builder_cstr(const string_builder* builder);
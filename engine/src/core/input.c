@@ -1,26 +1,99 @@
+#define LOG_CATEGORY LOG_CATEGORY_INPUT
+
 #include "core/input.h"
 #include "core/event.h"
 #include "core/fmemory.h"
 #include "core/logger.h"
+#include "platform/platform.h"
+
+// "FINP":
+#define INPUT_RECORDING_MAGIC 0x504E4946
+#define INPUT_RECORDING_VERSION 2
+// Records buffered before they are written out:
+#define INPUT_RECORD_BUFFER_COUNT 4096
+
+typedef enum input_record_type
+{
+    INPUT_RECORD_KEY,
+    INPUT_RECORD_MOUSE_BUTTON,
+    INPUT_RECORD_MOUSE_MOVE,
+    INPUT_RECORD_MOUSE_WHEEL,
+    // Written when recording stops, so replay runs for as many ticks as were recorded:
+    INPUT_RECORD_END
+} input_record_type;
 
-typedef struct keyboard_state
+typedef struct input_recording_header
 {
-    bool8_t keys[256];
-} keyboard_state;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+} input_recording_header;
+
+// One captured input_process_* call, written to the file as is:
+typedef struct input_record
+{
+    // Game ticks run since recording started:
+    uint32_t tick;
+    // Microseconds since recording started:
+    uint32_t time_us;
+    uint8_t type;
+    // Pressed state for keys and buttons, delta for the wheel:
+    int8_t value;
+    // Key or button:
+    uint16_t code;
+    int16_t x;
+    int16_t y;
+} input_record;
+
+STATIC_ASSERT(sizeof(input_record) == 16, "Expected input_record to be 16 bytes, it is part of the file format.");
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 typedef struct mouse_State
 {
     int32_t x;
     int32_t y;
-    uint8_t buttons[BUTTON_MAX_BUTTONS];
+    // One bit per MouseButtons value:
+    uint32_t buttons;
 } mouse_state;
 
 typedef struct input_state
 {
-    keyboard_state keyboard_current;
-    keyboard_state keyboard_previous;
+    input_key_mask keyboard_current;
+    input_key_mask keyboard_previous;
+    // Keys that went down/up since the previous frame, derived from the two masks above on first use:
+    input_key_mask keys_pressed;
+    input_key_mask keys_released;
+    bool8_t edges_dirty;
     mouse_state mouse_current;
     mouse_state mouse_previous;
+
+    // Game ticks run since initialization, which recordings are keyed on:
+    uint64_t tick_number;
+
+    // Monotonic time the platform stamped the input about to be processed with, or 0 to use the current time:
+    float64_t event_time;
+    // Earliest timestamp of the input processed since input_take_earliest_event_time was last called, or 0:
+    float64_t earliest_event_time;
+
+    platform_file recording_file;
+    input_record* recording_buffer;
+    uint32_t recording_buffered;
+    uint64_t recording_start_tick;
+    float64_t recording_start_time;
+    bool8_t recording;
+
+    input_record* replay_records;
+    uint64_t replay_count;
+    uint64_t replay_cursor;
+    uint64_t replay_start_tick;
+    bool8_t replaying;
+    // Set while recorded calls are fed back, which are the only input accepted during replay:
+    bool8_t replay_feeding;
+    bool8_t replay_quit_when_done;
 } input_state;
 
 // Internal input state:
@@ -36,7 +109,8 @@ void input_initialize()
 
 void input_shutdown()
 {
-    // TODO: Add shutdown routines when needed.
+    input_recording_stop();
+    input_replay_stop();
     initialized = FALSE;
 }
 
@@ -48,41 +122,386 @@ void input_update(float64_t delta_time)
     }
 
     // Copy current states to previous states:
-    fcopy_memory(&state.keyboard_previous, &state.keyboard_current, sizeof(keyboard_state));
-    fcopy_memory(&state.mouse_previous, &state.mouse_current, sizeof(mouse_state));
+    state.keyboard_previous = state.keyboard_current;
+    state.mouse_previous = state.mouse_current;
+    state.edges_dirty = TRUE;
+}
+
+void input_tick()
+{
+    state.tick_number++;
+}
+
+static uint32_t input_lowest_bit(uint64_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctzll(bits);
+#endif
+}
+
+// Recomputes the edge masks if a key changed since they were last computed. Written as whole-word operations over
+// the four words, which compilers turn into a couple of vector and/andnot instructions:
+static void input_update_edges()
+{
+    if (!state.edges_dirty)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        uint64_t current = state.keyboard_current.bits[i];
+        uint64_t previous = state.keyboard_previous.bits[i];
+        state.keys_pressed.bits[i] = current & ~previous;
+        state.keys_released.bits[i] = previous & ~current;
+    }
+    state.edges_dirty = FALSE;
+}
+
+static int16_t input_clamp_i16(int32_t value)
+{
+    return (int16_t)(value < -32768 ? -32768 : value > 32767 ? 32767 : value);
+}
+
+static void input_recording_flush()
+{
+    if (state.recording_buffered == 0)
+    {
+        return;
+    }
+
+    if (!platform_file_write(&state.recording_file, state.recording_buffer,
+        sizeof(input_record) * state.recording_buffered))
+    {
+        FERROR("Failed to write the input recording, recording stopped.");
+        state.recording = FALSE;
+        platform_file_close(&state.recording_file);
+        ffree(state.recording_buffer, sizeof(input_record) * INPUT_RECORD_BUFFER_COUNT, MEMORY_TAG_ARRAY);
+        state.recording_buffer = 0;
+    }
+    state.recording_buffered = 0;
+}
+
+static void input_record_call(input_record_type type, uint16_t code, int8_t value, int32_t x, int32_t y)
+{
+    if (!state.recording)
+    {
+        return;
+    }
+
+    float64_t elapsed_us = (platform_get_absolute_time() - state.recording_start_time) * 1000000.0;
+    input_record* record = &state.recording_buffer[state.recording_buffered++];
+    record->tick = (uint32_t)(state.tick_number - state.recording_start_tick);
+    record->time_us = elapsed_us < 4294967295.0 ? (uint32_t)elapsed_us : 0xFFFFFFFF;
+    record->type = (uint8_t)type;
+    record->value = value;
+    record->code = code;
+    record->x = input_clamp_i16(x);
+    record->y = input_clamp_i16(y);
+
+    if (state.recording_buffered == INPUT_RECORD_BUFFER_COUNT)
+    {
+        input_recording_flush();
+    }
+}
+
+// While replaying, input from the platform is dropped in favour of the recording:
+static bool8_t input_ignores_platform()
+{
+    return state.replaying && !state.replay_feeding;
+}
+
+// Folds the timestamp of the input being processed into the earliest pending one:
+static void input_note_event_time()
+{
+    float64_t time = state.event_time > 0 ? state.event_time : platform_get_absolute_time();
+    state.event_time = 0;
+    if (state.earliest_event_time == 0 || time < state.earliest_event_time)
+    {
+        state.earliest_event_time = time;
+    }
+}
+
+void input_set_event_time(float64_t timestamp)
+{
+    state.event_time = timestamp;
+}
+
+float64_t input_take_earliest_event_time()
+{
+    float64_t time = state.earliest_event_time;
+    state.earliest_event_time = 0;
+    return time;
+}
+
+bool8_t input_recording_start(const char* path)
+{
+    if (!initialized || state.recording)
+    {
+        FERROR("input_recording_start called while input is not initialized or already recording.");
+        return FALSE;
+    }
+
+    if (!platform_file_open(path, FALSE, &state.recording_file))
+    {
+        return FALSE;
+    }
+
+    input_recording_header header;
+    header.magic = INPUT_RECORDING_MAGIC;
+    header.version = INPUT_RECORDING_VERSION;
+    header.record_size = sizeof(input_record);
+    header.reserved = 0;
+    if (!platform_file_write(&state.recording_file, &header, sizeof(header)))
+    {
+        FERROR("Failed to write the input recording header to '%s'.", path);
+        platform_file_close(&state.recording_file);
+        return FALSE;
+    }
+
+    state.recording_buffer = fallocate(sizeof(input_record) * INPUT_RECORD_BUFFER_COUNT, MEMORY_TAG_ARRAY);
+    state.recording_buffered = 0;
+    state.recording_start_tick = state.tick_number;
+    state.recording_start_time = platform_get_absolute_time();
+    state.recording = TRUE;
+    FINFO("Recording input to '%s'.", path);
+    return TRUE;
+}
+
+void input_recording_stop()
+{
+    if (!state.recording)
+    {
+        return;
+    }
+
+    input_record_call(INPUT_RECORD_END, 0, 0, 0, 0);
+    input_recording_flush();
+    if (state.recording)
+    {
+        FINFO("Input recording stopped after %llu ticks.", state.tick_number - state.recording_start_tick);
+        state.recording = FALSE;
+        platform_file_close(&state.recording_file);
+        ffree(state.recording_buffer, sizeof(input_record) * INPUT_RECORD_BUFFER_COUNT, MEMORY_TAG_ARRAY);
+        state.recording_buffer = 0;
+    }
+}
+
+// Records index the key mask and button bits directly, so a corrupt or foreign file must not reach them:
+static bool8_t input_record_valid(const input_record* record)
+{
+    switch (record->type)
+    {
+        case INPUT_RECORD_KEY:
+            return record->code < sizeof(input_key_mask) * 8;
+        case INPUT_RECORD_MOUSE_BUTTON:
+            return record->code < BUTTON_MAX_BUTTONS;
+        case INPUT_RECORD_MOUSE_MOVE:
+        case INPUT_RECORD_MOUSE_WHEEL:
+        case INPUT_RECORD_END:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+bool8_t input_replay_start(const char* path, bool8_t quit_when_done)
+{
+    if (!initialized || state.replaying)
+    {
+        FERROR("input_replay_start called while input is not initialized or already replaying.");
+        return FALSE;
+    }
+
+    platform_file file;
+    if (!platform_file_open_read(path, &file))
+    {
+        FERROR("Failed to open input recording '%s'.", path);
+        return FALSE;
+    }
+
+    uint64_t size = 0;
+    input_recording_header header;
+    uint64_t read = 0;
+    if (!platform_file_size(&file, &size) || !platform_file_read(&file, &header, sizeof(header), &read) ||
+        read != sizeof(header) || header.magic != INPUT_RECORDING_MAGIC ||
+        header.version != INPUT_RECORDING_VERSION || header.record_size != sizeof(input_record))
+    {
+        FERROR("'%s' is not an input recording this version can replay.", path);
+        platform_file_close(&file);
+        return FALSE;
+    }
+
+    // A partially written last record (e.g. after a crash) is ignored:
+    uint64_t count = (size - sizeof(header)) / sizeof(input_record);
+    input_record* records = count ? fallocate(sizeof(input_record) * count, MEMORY_TAG_ARRAY) : 0;
+    if (count && (!platform_file_read(&file, records, sizeof(input_record) * count, &read) ||
+        read != sizeof(input_record) * count))
+    {
+        FERROR("Failed to read input recording '%s'.", path);
+        ffree(records, sizeof(input_record) * count, MEMORY_TAG_ARRAY);
+        platform_file_close(&file);
+        return FALSE;
+    }
+    platform_file_close(&file);
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (!input_record_valid(&records[i]))
+        {
+            FERROR("Input recording '%s' has an invalid record at index %llu (type %u, code %u).", path, i,
+                records[i].type, records[i].code);
+            ffree(records, sizeof(input_record) * count, MEMORY_TAG_ARRAY);
+            return FALSE;
+        }
+    }
+
+    state.replay_records = records;
+    state.replay_count = count;
+    state.replay_cursor = 0;
+    state.replay_start_tick = state.tick_number;
+    state.replay_quit_when_done = quit_when_done;
+    state.replaying = TRUE;
+    FINFO("Replaying %llu input records from '%s'.", count, path);
+    return TRUE;
+}
+
+void input_replay_stop()
+{
+    if (!state.replaying)
+    {
+        return;
+    }
+
+    if (state.replay_records)
+    {
+        ffree(state.replay_records, sizeof(input_record) * state.replay_count, MEMORY_TAG_ARRAY);
+    }
+    state.replay_records = 0;
+    state.replay_count = 0;
+    state.replaying = FALSE;
+}
+
+bool8_t input_is_replaying()
+{
+    return state.replaying;
+}
+
+bool8_t input_replay_is_due()
+{
+    return state.replaying && state.replay_cursor < state.replay_count &&
+        state.replay_records[state.replay_cursor].tick <= state.tick_number - state.replay_start_tick;
+}
+
+void input_replay_update()
+{
+    if (!state.replaying)
+    {
+        return;
+    }
+
+    uint64_t tick = state.tick_number - state.replay_start_tick;
+    bool8_t finished = FALSE;
+
+    state.replay_feeding = TRUE;
+    while (state.replay_cursor < state.replay_count && state.replay_records[state.replay_cursor].tick <= tick)
+    {
+        const input_record* record = &state.replay_records[state.replay_cursor++];
+        switch (record->type)
+        {
+            case INPUT_RECORD_KEY:
+                input_process_key((keys)record->code, record->value);
+                break;
+            case INPUT_RECORD_MOUSE_BUTTON:
+                input_process_mouse_button((MouseButtons)record->code, record->value);
+                break;
+            case INPUT_RECORD_MOUSE_MOVE:
+                input_process_mouse_move(record->x, record->y);
+                break;
+            case INPUT_RECORD_MOUSE_WHEEL:
+                input_process_mouse_wheel(record->value);
+                break;
+            case INPUT_RECORD_END:
+                finished = TRUE;
+                break;
+        }
+    }
+    state.replay_feeding = FALSE;
+
+    // Recordings cut short (no end record) finish with their last record:
+    if (!finished && state.replay_cursor < state.replay_count)
+    {
+        return;
+    }
+
+    FINFO("Input replay finished after %llu ticks.", tick);
+    bool8_t quit = state.replay_quit_when_done;
+    input_replay_stop();
+    if (quit)
+    {
+        event_context data = {};
+        event_fire(EVENT_CODE_APPLICATION_QUIT, 0, data);
+    }
 }
 
 void input_process_key(keys keyCode, bool8_t pressed)
 {
+    if (input_ignores_platform())
+    {
+        return;
+    }
+    input_note_event_time();
+    input_record_call(INPUT_RECORD_KEY, (uint16_t)keyCode, (int8_t)pressed, 0, 0);
+
     // Only handle if the state actually has changed:
-    if (state.keyboard_current.keys[keyCode] != pressed)
+    if (INPUT_KEY_MASK_TEST(state.keyboard_current, keyCode) != (pressed != FALSE))
     {
         // Update internal state:
-        state.keyboard_current.keys[keyCode] = pressed;
+        state.keyboard_current.bits[keyCode >> 6] ^= 1ull << (keyCode & 63);
+        state.edges_dirty = TRUE;
 
-        // Fire off an event for immediate processing:
+        // Post an event, dispatched once the message pump is done:
         event_context context;
         context.data.u16[0] = keyCode;
-        event_fire(pressed ? EVENT_CODE_KEY_PRESSED : EVENT_CODE_KEY_RELEASED, 0, context);
+        event_post(pressed ? EVENT_CODE_KEY_PRESSED : EVENT_CODE_KEY_RELEASED, 0, context);
     }
 }
 
 void input_process_mouse_button(MouseButtons button, bool8_t pressed)
 {
-   // If the state has changed, fire an event:
-    if (state.mouse_previous.buttons[button] != pressed)
+    if (input_ignores_platform())
     {
-        state.mouse_previous.buttons[button] = pressed;
+        return;
+    }
+    input_note_event_time();
+    input_record_call(INPUT_RECORD_MOUSE_BUTTON, (uint16_t)button, (int8_t)pressed, 0, 0);
 
-        // Fire the event:
+    // If the state has changed, fire an event:
+    uint32_t bit = 1u << button;
+    if (((state.mouse_current.buttons & bit) != 0) != (pressed != FALSE))
+    {
+        state.mouse_current.buttons ^= bit;
+
+        // Post the event:
         event_context context;
         context.data.u16[0] = button;
-        event_fire(pressed ? EVENT_CODE_MOUSE_BUTTON_PRESSED : EVENT_CODE_MOUSE_BUTTON_RELEASED, 0, context);
+        event_post(pressed ? EVENT_CODE_MOUSE_BUTTON_PRESSED : EVENT_CODE_MOUSE_BUTTON_RELEASED, 0, context);
     }
 }
 
 void input_process_mouse_move(int32_t x, int32_t y)
 {
+    if (input_ignores_platform())
+    {
+        return;
+    }
+    input_note_event_time();
+    input_record_call(INPUT_RECORD_MOUSE_MOVE, 0, 0, x, y);
+
     // Only process if actually different:
     if (state.mouse_current.x != x || state.mouse_current.y != y)
     {
@@ -93,22 +512,29 @@ void input_process_mouse_move(int32_t x, int32_t y)
         state.mouse_current.x = x;
         state.mouse_current.y = y;
 
-        // Fire the event:
+        // Post the event:
         event_context context;
         context.data.u32[0] = x;
         context.data.u32[1] = y;
-        event_fire(EVENT_CODE_MOUSE_MOVED, 0, context);
+        event_post(EVENT_CODE_MOUSE_MOVED, 0, context);
     }
 }
 
 void input_process_mouse_wheel(int8_t z_delta)
 {
+    if (input_ignores_platform())
+    {
+        return;
+    }
+    input_note_event_time();
+    input_record_call(INPUT_RECORD_MOUSE_WHEEL, 0, z_delta, 0, 0);
+
     // N.B: No internal state to update.
 
-    // Fire the event:
+    // Post the event:
     event_context context;
     context.data.u8[0] = z_delta;
-    event_fire(EVENT_CODE_MOUSE_WHEEL, 0, context);
+    event_post(EVENT_CODE_MOUSE_WHEEL, 0, context);
 }
 
 bool8_t input_is_key_down(keys keyCode)
@@ -117,7 +543,7 @@ bool8_t input_is_key_down(keys keyCode)
     {
         return FALSE;
     }
-    return state.keyboard_current.keys[keyCode] == TRUE;
+    return INPUT_KEY_MASK_TEST(state.keyboard_current, keyCode);
 }
 
 bool8_t input_is_key_up(keys keyCode)
@@ -126,7 +552,7 @@ bool8_t input_is_key_up(keys keyCode)
     {
         return TRUE;
     }
-    return state.keyboard_current.keys[keyCode] == FALSE;
+    return !INPUT_KEY_MASK_TEST(state.keyboard_current, keyCode);
 }
 
 bool8_t input_was_key_down(keys keyCode)
@@ -135,7 +561,7 @@ bool8_t input_was_key_down(keys keyCode)
     {
         return FALSE;
     }
-    return state.keyboard_previous.keys[keyCode] == TRUE;
+    return INPUT_KEY_MASK_TEST(state.keyboard_previous, keyCode);
 }
 
 bool8_t input_was_key_up(keys keyCode)
@@ -144,7 +570,96 @@ bool8_t input_was_key_up(keys keyCode)
     {
         return TRUE;
     }
-    return state.keyboard_previous.keys[keyCode] == FALSE;
+    return !INPUT_KEY_MASK_TEST(state.keyboard_previous, keyCode);
+}
+
+bool8_t input_is_key_pressed(keys keyCode)
+{
+    if (!initialized)
+    {
+        return FALSE;
+    }
+    input_update_edges();
+    return INPUT_KEY_MASK_TEST(state.keys_pressed, keyCode);
+}
+
+bool8_t input_is_key_released(keys keyCode)
+{
+    if (!initialized)
+    {
+        return FALSE;
+    }
+    input_update_edges();
+    return INPUT_KEY_MASK_TEST(state.keys_released, keyCode);
+}
+
+void input_get_key_masks(input_key_mask* out_down, input_key_mask* out_pressed, input_key_mask* out_released)
+{
+    input_key_mask none = {};
+    if (initialized)
+    {
+        input_update_edges();
+    }
+
+    if (out_down)
+    {
+        *out_down = initialized ? state.keyboard_current : none;
+    }
+    if (out_pressed)
+    {
+        *out_pressed = initialized ? state.keys_pressed : none;
+    }
+    if (out_released)
+    {
+        *out_released = initialized ? state.keys_released : none;
+    }
+}
+
+static bool8_t input_key_mask_intersects(const input_key_mask* a, const input_key_mask* b)
+{
+    return ((a->bits[0] & b->bits[0]) | (a->bits[1] & b->bits[1]) |
+        (a->bits[2] & b->bits[2]) | (a->bits[3] & b->bits[3])) != 0;
+}
+
+bool8_t input_any_key_down(const input_key_mask* key_set)
+{
+    if (!initialized)
+    {
+        return FALSE;
+    }
+    return input_key_mask_intersects(&state.keyboard_current, key_set);
+}
+
+bool8_t input_any_key_pressed(const input_key_mask* key_set)
+{
+    if (!initialized)
+    {
+        return FALSE;
+    }
+    input_update_edges();
+    return input_key_mask_intersects(&state.keys_pressed, key_set);
+}
+
+uint32_t input_get_pressed_keys(keys* out_keys, uint32_t max_count)
+{
+    if (!initialized)
+    {
+        return 0;
+    }
+    input_update_edges();
+
+    // Visits set bits only, lowest key first:
+    uint32_t count = 0;
+    for (uint32_t word = 0; word < 4; ++word)
+    {
+        uint64_t bits = state.keys_pressed.bits[word];
+        while (bits && count < max_count)
+        {
+            out_keys[count++] = (keys)(word * 64 + input_lowest_bit(bits));
+            bits &= bits - 1;
+        }
+    }
+    return count;
 }
 
 bool8_t input_is_mouse_button_down(MouseButtons button)
@@ -153,7 +668,7 @@ bool8_t input_is_mouse_button_down(MouseButtons button)
     {
         return FALSE;
     }
-    return state.mouse_current.buttons[button] == TRUE;
+    return (state.mouse_current.buttons & (1u << button)) != 0;
 }
 
 bool8_t input_is_mouse_button_up(MouseButtons button)
@@ -162,7 +677,7 @@ bool8_t input_is_mouse_button_up(MouseButtons button)
     {
         return TRUE;
     }
-    return state.mouse_current.buttons[button] == FALSE;
+    return (state.mouse_current.buttons & (1u << button)) == 0;
 }
 
 bool8_t input_was_mouse_button_down(MouseButtons button)
@@ -171,7 +686,7 @@ bool8_t input_was_mouse_button_down(MouseButtons button)
     {
         return FALSE;
     }
-    return state.mouse_previous.buttons[button] == TRUE;
+    return (state.mouse_previous.buttons & (1u << button)) != 0;
 }
 
 bool8_t input_was_mouse_button_up(MouseButtons button)
@@ -180,7 +695,30 @@ bool8_t input_was_mouse_button_up(MouseButtons button)
     {
         return TRUE;
     }
-    return state.mouse_previous.buttons[button] == FALSE;
+    return (state.mouse_previous.buttons & (1u << button)) == 0;
+}
+
+bool8_t input_is_mouse_button_pressed(MouseButtons button)
+{
+    if (!initialized)
+    {
+        return FALSE;
+    }
+    return (state.mouse_current.buttons & ~state.mouse_previous.buttons & (1u << button)) != 0;
+}
+
+bool8_t input_is_mouse_button_released(MouseButtons button)
+{
+    if (!initialized)
+    {
+        return FALSE;
+    }
+    return (state.mouse_previous.buttons & ~state.mouse_current.buttons & (1u << button)) != 0;
+}
+
+uint32_t input_get_mouse_buttons()
+{
+    return initialized ? state.mouse_current.buttons : 0;
 }
 
 void input_get_mouse_position(int32_t* x, int32_t* y)
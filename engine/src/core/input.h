@@ -145,9 +145,24 @@ typedef enum keys
     KEYS_MAX_KEYS
 } keys;
 
+/*
+ * 256-bit set of keys, one bit per keys value. Key state is kept in this form, so a set of keys is tested with a
+ * few word operations instead of one query per key.
+ */
+typedef struct input_key_mask
+{
+    uint64_t bits[4];
+} input_key_mask;
+
+#define INPUT_KEY_MASK_SET(mask, key) ((mask).bits[(key) >> 6] |= 1ull << ((key) & 63))
+#define INPUT_KEY_MASK_CLEAR(mask, key) ((mask).bits[(key) >> 6] &= ~(1ull << ((key) & 63)))
+#define INPUT_KEY_MASK_TEST(mask, key) (((mask).bits[(key) >> 6] >> ((key) & 63)) & 1)
+
 void input_initialize();
 void input_shutdown();
 void input_update(float64_t delta_time);
+// Counts a game tick. Called by the application after each game update; recording and replay are keyed on it:
+void input_tick();
 
 // -- Keyboard Input Querying --
 FAPI bool8_t input_is_key_down(keys keyCode);
@@ -155,6 +170,27 @@ FAPI bool8_t input_is_key_up(keys keyCode);
 FAPI bool8_t input_was_key_down(keys keyCode);
 FAPI bool8_t input_was_key_up(keys keyCode);
 
+// TRUE if the key went down/up since the previous frame:
+FAPI bool8_t input_is_key_pressed(keys keyCode);
+FAPI bool8_t input_is_key_released(keys keyCode);
+
+// -- Bulk Keyboard Querying --
+
+// Gets the keys currently down and the ones that went down/up since the previous frame. Any output can be 0/NULL.
+FAPI void input_get_key_masks(input_key_mask* out_down, input_key_mask* out_pressed, input_key_mask* out_released);
+
+// TRUE if any key in the set is down / went down since the previous frame:
+FAPI bool8_t input_any_key_down(const input_key_mask* key_set);
+FAPI bool8_t input_any_key_pressed(const input_key_mask* key_set);
+
+/**
+ * Lists the keys that went down since the previous frame, lowest key code first.
+ * @param out_keys Receives up to max_count keys.
+ * @param max_count The number of keys out_keys can hold.
+ * @returns The number of keys written.
+ */
+FAPI uint32_t input_get_pressed_keys(keys* out_keys, uint32_t max_count);
+
 void input_process_key(keys keyCode, bool8_t pressed);
 
 // -- Mouse Input Querying --
@@ -162,10 +198,65 @@ FAPI bool8_t input_is_mouse_button_down(MouseButtons button);
 FAPI bool8_t input_is_mouse_button_up(MouseButtons button);
 FAPI bool8_t input_was_mouse_button_down(MouseButtons button);
 FAPI bool8_t input_was_mouse_button_up(MouseButtons button);
+FAPI bool8_t input_is_mouse_button_pressed(MouseButtons button);
+FAPI bool8_t input_is_mouse_button_released(MouseButtons button);
+
+// Returns the buttons currently down, one bit per MouseButtons value:
+FAPI uint32_t input_get_mouse_buttons();
 
 FAPI void input_get_mouse_position(int32_t* x, int32_t* y);
 FAPI void input_get_previous_mouse_position(int32_t* x, int32_t* y);
 
 void input_process_mouse_button(MouseButtons button, bool8_t pressed);
 void input_process_mouse_move(int32_t x, int32_t y);
-void input_process_mouse_wheel(int8_t z_delta);
\ No newline at end of file
+void input_process_mouse_wheel(int8_t z_delta);
+
+// -- Recording and replay --
+// Captures every input_process_* call, with the number of game ticks run before it and a timestamp, to a compact
+// binary file, and feeds such a file back through the input system in place of the platform's input. Replay is
+// keyed on ticks rather than frames, since how many ticks a frame runs depends on timing: a replayed run sees the
+// same input before the same tick every time. The application starts either one from the
+// FOO_INPUT_RECORD/FOO_INPUT_REPLAY environment variables; a replay started that way quits when it ends.
+
+/**
+ * Starts recording to path, replacing the file. Recording stops with input_recording_stop or on shutdown.
+ * @returns TRUE if the file could be created; otherwise FALSE.
+ */
+FAPI bool8_t input_recording_start(const char* path);
+FAPI void input_recording_stop();
+
+/**
+ * Starts replaying a recording made by input_recording_start. Input from the platform is ignored until the
+ * replay ends, and the recorded calls are fed back before the tick they were recorded before, relative to the tick
+ * replay started on.
+ * @param path The recording to replay.
+ * @param quit_when_done If TRUE, EVENT_CODE_APPLICATION_QUIT is fired after the last recorded tick.
+ * @returns TRUE if the recording could be loaded; otherwise FALSE.
+ */
+FAPI bool8_t input_replay_start(const char* path, bool8_t quit_when_done);
+FAPI void input_replay_stop();
+FAPI bool8_t input_is_replaying();
+
+// Feeds the recorded input due before the next tick. Called by the application right after pumping messages.
+void input_replay_update();
+
+// TRUE while replaying if recorded input is due before the next tick. The application then stops ticking for the
+// frame, so the input is fed at the start of the next one, before that tick runs.
+bool8_t input_replay_is_due();
+
+// -- Input latency --
+// Every processed input is timestamped on the platform_get_absolute_time clock, so the renderer can measure how long
+// the oldest input of a frame took to reach submission and presentation.
+
+/**
+ * Sets the timestamp of the next input_process_* call. Called by the platform layer with the OS event time, mapped
+ * onto platform_get_absolute_time's clock. Input processed without one is stamped with the time it is processed.
+ * @param timestamp The event time in seconds, or 0 for none.
+ */
+void input_set_event_time(float64_t timestamp);
+
+/**
+ * Returns the timestamp of the earliest input processed since the previous call, and clears it.
+ * @returns The timestamp in seconds, or 0 if no input was processed.
+ */
+FAPI float64_t input_take_earliest_event_time();
\ No newline at end of file
@@ -0,0 +1,335 @@
+#define LOG_CATEGORY LOG_CATEGORY_INPUT
+
+#include "core/input_actions.h"
+#include "core/event.h"
+#include "core/fmemory.h"
+#include "core/fstring.h"
+#include "core/logger.h"
+#include "containers/darray.h"
+
+typedef struct action_entry
+{
+    string_id name;
+    bool8_t is_axis;
+    float32_t value;
+} action_entry;
+
+typedef struct action_binding
+{
+    input_binding binding;
+    float32_t scale;
+    input_action action;
+    // Compiled bindings only: the range of shadows listing the bindings this one is a strict subset of:
+    uint32_t shadow_first;
+    uint32_t shadow_count;
+} action_binding;
+
+typedef struct input_actions_state
+{
+    action_entry* actions;
+    // Bindings as added, grouped per action when compiled:
+    action_binding* bindings;
+    // Flat table evaluated each frame, rebuilt from bindings when dirty:
+    action_binding* compiled;
+    // Indices into compiled, see action_binding.shadow_first:
+    uint32_t* shadows;
+    // Per-frame state of each compiled binding, TRUE while all its keys and buttons are down:
+    bool8_t* held;
+    // Per-frame sums of the held bindings' scales, one per action:
+    float32_t* sums;
+    bool8_t dirty;
+} input_actions_state;
+
+static bool8_t initialized = FALSE;
+static input_actions_state state;
+
+bool8_t input_actions_initialize()
+{
+    if (initialized)
+    {
+        return FALSE;
+    }
+
+    fzero_memory(&state, sizeof(state));
+    state.actions = darray_create(action_entry);
+    state.bindings = darray_create(action_binding);
+    state.compiled = darray_create(action_binding);
+    state.shadows = darray_create(uint32_t);
+    state.held = darray_create(bool8_t);
+    state.sums = darray_create(float32_t);
+    initialized = TRUE;
+    return TRUE;
+}
+
+void input_actions_shutdown()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    darray_destroy(state.actions);
+    darray_destroy(state.bindings);
+    darray_destroy(state.compiled);
+    darray_destroy(state.shadows);
+    darray_destroy(state.held);
+    darray_destroy(state.sums);
+    fzero_memory(&state, sizeof(state));
+    initialized = FALSE;
+}
+
+input_action input_action_find(const char* name)
+{
+    if (!initialized)
+    {
+        return INVALID_INPUT_ACTION;
+    }
+
+    string_id id = string_id_find(string_view_create(name));
+    uint64_t count = darray_length(state.actions);
+    for (uint64_t i = 0; id != INVALID_STRING_ID && i < count; ++i)
+    {
+        if (state.actions[i].name == id)
+        {
+            return (input_action)i;
+        }
+    }
+    return INVALID_INPUT_ACTION;
+}
+
+input_action input_action_create(const char* name, bool8_t is_axis)
+{
+    if (!initialized)
+    {
+        return INVALID_INPUT_ACTION;
+    }
+
+    input_action existing = input_action_find(name);
+    if (existing != INVALID_INPUT_ACTION)
+    {
+        if (state.actions[existing].is_axis != is_axis)
+        {
+            FERROR("Input action '%s' already exists as %s.", name, is_axis ? "an action" : "an axis");
+            return INVALID_INPUT_ACTION;
+        }
+        return existing;
+    }
+
+    if (darray_length(state.actions) >= INVALID_INPUT_ACTION)
+    {
+        FERROR("Too many input actions, '%s' was not created.", name);
+        return INVALID_INPUT_ACTION;
+    }
+
+    action_entry entry;
+    entry.name = string_intern(name);
+    entry.is_axis = is_axis;
+    entry.value = 0;
+    darray_push(state.actions, entry);
+
+    float32_t sum = 0;
+    darray_push(state.sums, sum);
+    return (input_action)(darray_length(state.actions) - 1);
+}
+
+bool8_t input_action_bind(input_action action, const input_binding* binding, float32_t scale)
+{
+    if (!initialized || action >= darray_length(state.actions))
+    {
+        return FALSE;
+    }
+
+    const uint64_t* bits = binding->keys.bits;
+    if ((bits[0] | bits[1] | bits[2] | bits[3]) == 0 && binding->mouse_buttons == 0)
+    {
+        FERROR("Empty binding for input action '%s' ignored.", string_id_str(state.actions[action].name));
+        return FALSE;
+    }
+
+    action_binding entry;
+    entry.binding = *binding;
+    entry.scale = state.actions[action].is_axis ? scale : 1.0f;
+    entry.action = action;
+    darray_push(state.bindings, entry);
+    state.dirty = TRUE;
+    return TRUE;
+}
+
+bool8_t input_action_bind_key(input_action action, keys key, float32_t scale)
+{
+    input_binding binding = {};
+    INPUT_KEY_MASK_SET(binding.keys, key);
+    return input_action_bind(action, &binding, scale);
+}
+
+bool8_t input_action_bind_mouse_button(input_action action, MouseButtons button, float32_t scale)
+{
+    input_binding binding = {};
+    binding.mouse_buttons = 1u << button;
+    return input_action_bind(action, &binding, scale);
+}
+
+void input_action_clear_bindings(input_action action)
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    uint64_t count = darray_length(state.bindings);
+    uint64_t kept = 0;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (state.bindings[i].action != action)
+        {
+            state.bindings[kept++] = state.bindings[i];
+        }
+    }
+    darray_length_set(state.bindings, kept);
+    state.dirty = TRUE;
+}
+
+// TRUE if every key and button of inner is also in outer:
+static bool8_t input_binding_contains(const input_binding* outer, const input_binding* inner)
+{
+    uint64_t missing = (inner->keys.bits[0] & ~outer->keys.bits[0]) | (inner->keys.bits[1] & ~outer->keys.bits[1]) |
+        (inner->keys.bits[2] & ~outer->keys.bits[2]) | (inner->keys.bits[3] & ~outer->keys.bits[3]) |
+        (inner->mouse_buttons & ~outer->mouse_buttons);
+    return missing == 0;
+}
+
+// Rebuilds the flat table, with the bindings of each action next to each other, and works out which bindings are
+// shadowed by chords containing them:
+static void input_actions_compile()
+{
+    darray_clear(state.compiled);
+    uint64_t action_count = darray_length(state.actions);
+    uint64_t binding_count = darray_length(state.bindings);
+    for (uint64_t action = 0; action < action_count; ++action)
+    {
+        for (uint64_t i = 0; i < binding_count; ++i)
+        {
+            if (state.bindings[i].action == action)
+            {
+                darray_push(state.compiled, state.bindings[i]);
+            }
+        }
+    }
+
+    darray_clear(state.shadows);
+    darray_clear(state.held);
+    uint32_t compiled_count = (uint32_t)darray_length(state.compiled);
+    for (uint32_t i = 0; i < compiled_count; ++i)
+    {
+        bool8_t held = FALSE;
+        darray_push(state.held, held);
+
+        action_binding* b = &state.compiled[i];
+        b->shadow_first = (uint32_t)darray_length(state.shadows);
+        for (uint32_t j = 0; j < compiled_count; ++j)
+        {
+            const input_binding* other = &state.compiled[j].binding;
+            if (input_binding_contains(other, &b->binding) && !input_binding_contains(&b->binding, other))
+            {
+                darray_push(state.shadows, j);
+            }
+        }
+        b->shadow_count = (uint32_t)darray_length(state.shadows) - b->shadow_first;
+    }
+    state.dirty = FALSE;
+}
+
+void input_actions_update()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    if (state.dirty)
+    {
+        input_actions_compile();
+    }
+
+    input_key_mask down;
+    input_get_key_masks(&down, 0, 0);
+    uint32_t buttons = input_get_mouse_buttons();
+
+    uint64_t action_count = darray_length(state.actions);
+    fzero_memory(state.sums, sizeof(float32_t) * action_count);
+
+    // One pass of mask tests, without branching per key:
+    uint64_t binding_count = darray_length(state.compiled);
+    for (uint64_t i = 0; i < binding_count; ++i)
+    {
+        const action_binding* b = &state.compiled[i];
+        uint64_t missing = (b->binding.keys.bits[0] & ~down.bits[0]) | (b->binding.keys.bits[1] & ~down.bits[1]) |
+            (b->binding.keys.bits[2] & ~down.bits[2]) | (b->binding.keys.bits[3] & ~down.bits[3]) |
+            (b->binding.mouse_buttons & ~buttons);
+        state.held[i] = missing == 0;
+    }
+
+    // A held chord suppresses the bindings it contains, so Ctrl+S doesn't also count as S:
+    for (uint64_t i = 0; i < binding_count; ++i)
+    {
+        if (!state.held[i])
+        {
+            continue;
+        }
+
+        const action_binding* b = &state.compiled[i];
+        bool8_t shadowed = FALSE;
+        for (uint32_t s = 0; s < b->shadow_count && !shadowed; ++s)
+        {
+            shadowed = state.held[state.shadows[b->shadow_first + s]];
+        }
+        state.sums[b->action] += shadowed ? 0.0f : b->scale;
+    }
+
+    // Only changes produce events:
+    for (uint64_t i = 0; i < action_count; ++i)
+    {
+        action_entry* entry = &state.actions[i];
+        float32_t value = state.sums[i];
+        if (entry->is_axis)
+        {
+            value = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+        }
+        else
+        {
+            value = value != 0.0f ? 1.0f : 0.0f;
+        }
+
+        if (value == entry->value)
+        {
+            continue;
+        }
+
+        uint16_t code = entry->is_axis ? EVENT_CODE_AXIS_CHANGED :
+            value != 0.0f ? EVENT_CODE_ACTION_STARTED : EVENT_CODE_ACTION_ENDED;
+        entry->value = value;
+
+        event_context context = {};
+        context.data.u16[0] = (uint16_t)i;
+        context.data.f32[1] = value;
+        event_post(code, 0, context);
+    }
+}
+
+bool8_t input_action_is_active(input_action action)
+{
+    if (!initialized || action >= darray_length(state.actions))
+    {
+        return FALSE;
+    }
+    return state.actions[action].value != 0.0f;
+}
+
+float32_t input_action_value(input_action action)
+{
+    if (!initialized || action >= darray_length(state.actions))
+    {
+        return 0.0f;
+    }
+    return state.actions[action].value;
+}
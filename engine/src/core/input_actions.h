@@ -0,0 +1,65 @@
+#pragma once
+
+#include "defines.h"
+#include "core/input.h"
+
+/*
+ * Named actions and axes on top of core/input.
+ *
+ * Bindings (single keys, mouse buttons or chords of both) are compiled into one flat table, and each frame the
+ * table is evaluated in a single linear pass of mask tests against the current key and button state. Game code then
+ * queries actions by id, or listens for EVENT_CODE_ACTION_STARTED/ENDED and EVENT_CODE_AXIS_CHANGED, which are only
+ * posted when an action's value changes. Main thread only.
+ *
+ * While a chord is held, bindings whose keys and buttons are a strict subset of it don't count: with "save" bound to
+ * Ctrl+S and "move" to S, holding Ctrl+S activates only "save".
+ */
+
+typedef uint16_t input_action;
+
+#define INVALID_INPUT_ACTION 0xFFFF
+
+// Holds while every key and every mouse button in it is down:
+typedef struct input_binding
+{
+    input_key_mask keys;
+    // One bit per MouseButtons value:
+    uint32_t mouse_buttons;
+} input_binding;
+
+bool8_t input_actions_initialize();
+void input_actions_shutdown();
+
+// Evaluates all bindings and posts events for the actions that changed. Called once per frame by the application.
+void input_actions_update();
+
+/**
+ * Creates an action, or returns the existing one with that name.
+ * @param name The action name, e.g. "jump".
+ * @param is_axis TRUE for an axis, whose value is the sum of the scales of its held bindings clamped to [-1, 1];
+ *                FALSE for a button-like action that is either active or not.
+ * @returns The action, or INVALID_INPUT_ACTION if it exists with the other kind.
+ */
+FAPI input_action input_action_create(const char* name, bool8_t is_axis);
+
+// Returns the action with the given name, or INVALID_INPUT_ACTION:
+FAPI input_action input_action_find(const char* name);
+
+/**
+ * Adds a binding to an action. Bindings with several keys/buttons act as chords. The binding table is recompiled
+ * before the next evaluation.
+ * @param action The action to bind.
+ * @param binding The keys and buttons that must all be held. Must not be empty.
+ * @param scale The value this binding contributes to an axis while held, e.g. -1 and 1. Ignored for actions.
+ * @returns TRUE if the binding was added; otherwise FALSE.
+ */
+FAPI bool8_t input_action_bind(input_action action, const input_binding* binding, float32_t scale);
+FAPI bool8_t input_action_bind_key(input_action action, keys key, float32_t scale);
+FAPI bool8_t input_action_bind_mouse_button(input_action action, MouseButtons button, float32_t scale);
+
+FAPI void input_action_clear_bindings(input_action action);
+
+FAPI bool8_t input_action_is_active(input_action action);
+
+// Returns the value of an axis in [-1, 1], or 1/0 for an active/inactive action:
+FAPI float32_t input_action_value(input_action action);
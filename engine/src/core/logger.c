@@ -1,50 +1,1652 @@
 #include "logger.h"
 #include "asserts.h"
+#include "fstring.h"
+#include "arena.h"
 #include "platform/platform.h"
 
-// TODO: Temp, remove later.
-#include <stdio.h>
-#include <string.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 
-const int32_t KMESSAGE_SIZE = 32000;
+// Most messages fit in a stack buffer; longer ones grow into a heap buffer, so there is no length limit:
+#define LOG_STACK_BUFFER_SIZE 2048
+
+/*
+ * Asynchronous output.
+ *
+ * Callers format on their own stack and copy the text into a bounded multi-producer/single-consumer ring of
+ * fixed-size slots; a message longer than one slot claims several consecutive slots with a single CAS. A
+ * writer thread drains the ring and hands runs of same-level messages to the console in one write, so a log
+ * call costs a format and a copy and never waits on the console.
+ *
+ * Each slot carries a sequence number (Vyukov-style): a slot is free for position p when its sequence is p,
+ * holds a published message when it is p + 1, and is released by the writer by storing p + slot count.
+ */
+
+// Must be a power of two:
+#define LOG_RING_SLOT_COUNT 2048
+#define LOG_RING_SLOT_SIZE 256
+// Longer messages are truncated to this many slots:
+#define LOG_RING_MAX_SLOTS_PER_MESSAGE 64
+#define LOG_WRITE_BATCH_SIZE (64 * 1024)
+// The writer re-checks the ring at least this often even if no wake-up arrives:
+#define LOG_WRITER_IDLE_WAIT_MS 50
+// Upper bound on how long an error waits for room in a full ring, and a fatal message for queued output to be
+// written:
+#define LOG_FATAL_FLUSH_TIMEOUT_MS 250
+// Text log file output is collected here and written in one call per flush interval:
+#define LOG_FILE_BUFFER_SIZE (256 * 1024)
+#define LOG_FILE_PATH_MAX 256
+
+// Rate limiting, per call site (keyed by format string address). Must be a power of two:
+#define LOG_CALLSITE_CAPACITY 1024
+#define LOG_CALLSITE_MAX_PROBES 16
+#define LOG_DEFAULT_RATE_BURST 30
+#define LOG_DEFAULT_RATE_WINDOW 1.0
+// How much of a format string is quoted in a suppression summary:
+#define LOG_SUMMARY_FORMAT_LENGTH 80
+
+#define LOG_SLOT_TEXT_SIZE (LOG_RING_SLOT_SIZE - sizeof(uint64_t) - sizeof(uint32_t))
+
+// Slot level marking a chunk of binary log records rather than text:
+#define LOG_RECORD_BINARY 0xFF
+#define LOG_BINARY_FILE_PATH "console.flog"
+#define LOG_BINARY_VERSION 1
+
+typedef struct log_slot
+{
+    _Atomic uint64_t sequence;
+    // Text bytes stored in this slot:
+    uint16_t length;
+    uint8_t level;
+    // Number of slots the message spans. Only read from its first slot:
+    uint8_t slot_count;
+    char text[LOG_SLOT_TEXT_SIZE];
+} log_slot;
+
+STATIC_ASSERT(sizeof(log_slot) == LOG_RING_SLOT_SIZE, "Expected log_slot to fill exactly one ring slot.");
+
+/*
+ * Per call site limits. Each call site may log rate_burst messages per rate_window seconds; the rest are
+ * counted and skipped before they are formatted. A text message identical to the previous one from the same
+ * call site is counted instead of written. The writer thread reports both counts once per window.
+ */
+typedef struct log_callsite
+{
+    // 0 while the entry is free:
+    _Atomic(const char*) format;
+    // Try-lock. A call site busy on another thread is simply not limited for that call:
+    _Atomic bool8_t locked;
+    uint8_t level;
+    uint32_t window_count;
+    float64_t window_start;
+    // Pending counts for the next summary:
+    uint32_t suppressed;
+    uint32_t repeats;
+    uint32_t last_hash;
+} log_callsite;
+
+typedef struct logger_state
+{
+    _Alignas(64) log_slot slots[LOG_RING_SLOT_COUNT];
+
+    // Next position producers claim:
+    _Alignas(64) _Atomic uint64_t write_position;
+    // Every position below this has been written to the console. Advanced by the writer thread only:
+    _Alignas(64) _Atomic uint64_t flushed_position;
+    _Atomic uint64_t dropped_count;
+    _Atomic bool8_t writer_sleeping;
+    _Atomic bool8_t running;
+
+    platform_thread writer;
+    platform_semaphore wake;
+
+    // Writer thread only:
+    uint64_t read_position;
+    char batch[LOG_WRITE_BATCH_SIZE + 1];
+    uint64_t batch_length;
+    uint8_t batch_level;
+    uint8_t binary_batch[LOG_WRITE_BATCH_SIZE];
+    uint64_t binary_batch_length;
+    // Opened on the first binary chunk, so text-only sessions don't leave an empty file behind:
+    platform_file binary_file;
+    bool8_t binary_file_failed;
+
+    // Text log file. Owned by the writer thread once it is running:
+    log_file_config file_config;
+    char file_path[LOG_FILE_PATH_MAX];
+    platform_file file;
+    char file_buffer[LOG_FILE_BUFFER_SIZE];
+    uint64_t file_buffer_length;
+    uint64_t file_size;
+    float64_t file_opened_time;
+    float64_t file_flush_time;
+    bool8_t file_flush_requested;
+
+    log_callsite callsites[LOG_CALLSITE_CAPACITY];
+    // 0 disables rate limiting and repeat collapsing:
+    uint32_t rate_burst;
+    float64_t rate_window;
+    // Writer thread only:
+    float64_t last_sweep_time;
+
+    // Binary logging. Format ids start at 1; 0 marks an unregistered call site:
+    struct log_binary_format* binary_formats;
+    _Atomic uint32_t binary_format_count;
+    _Atomic uint32_t binary_thread_count;
+} logger_state;
+
+static logger_state state = {
+    .file_config = {
+        .path = "console.log",
+        .max_size = 64 * 1024 * 1024,
+        .max_age_seconds = 0,
+        .rotation_count = 5,
+        .flush_interval_ms = 1000,
+        .sync = LOG_FILE_SYNC_NONE,
+    },
+    .rate_burst = LOG_DEFAULT_RATE_BURST,
+    .rate_window = LOG_DEFAULT_RATE_WINDOW,
+};
+
+#if FRELEASE == 1
+#define LOG_DEFAULT_CATEGORY_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_DEFAULT_CATEGORY_LEVEL LOG_LEVEL_TRACE
+#endif
+
+uint8_t log_category_levels[LOG_CATEGORY_MAX] = {[0 ... LOG_CATEGORY_MAX - 1] = LOG_DEFAULT_CATEGORY_LEVEL};
+
+static const char* level_strings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]:  ", "[INFO]:  ", "[DEBUG]: ", "[TRACE]: "};
+
+static void log_write_console(log_level level, const char* text)
+{
+    // Platform-specific output.
+    if (level < LOG_LEVEL_WARN)
+    {
+        platform_console_write_error(text, level);
+    }
+    else
+    {
+        platform_console_write(text, level);
+    }
+}
+
+static void log_batch_emit()
+{
+    if (state.batch_length)
+    {
+        state.batch[state.batch_length] = 0;
+        log_write_console(state.batch_level, state.batch);
+        state.batch_length = 0;
+    }
+}
+
+// Shifts path.N-1 to path.N, ..., path to path.1, dropping the oldest. Missing files are skipped.
+static void log_file_rotate_names()
+{
+    char from_buffer[LOG_FILE_PATH_MAX + 16];
+    char to_buffer[LOG_FILE_PATH_MAX + 16];
+    string_builder from;
+    string_builder to;
+    string_builder_create_from_buffer(from_buffer, sizeof(from_buffer), 0, &from);
+    string_builder_create_from_buffer(to_buffer, sizeof(to_buffer), 0, &to);
+
+    for (uint32_t i = state.file_config.rotation_count; i > 0; --i)
+    {
+        string_builder_clear(&from);
+        string_builder_clear(&to);
+        string_builder_append(&from, state.file_path);
+        if (i > 1)
+        {
+            string_builder_append_char(&from, '.');
+            string_builder_append_u64(&from, i - 1);
+        }
+        string_builder_append(&to, state.file_path);
+        string_builder_append_char(&to, '.');
+        string_builder_append_u64(&to, i);
+        platform_file_rename(string_builder_cstr(&from), string_builder_cstr(&to));
+    }
+
+    string_builder_destroy(&from);
+    string_builder_destroy(&to);
+}
+
+static bool8_t log_file_open()
+{
+    log_file_rotate_names();
+    if (!platform_file_open(state.file_path, FALSE, &state.file))
+    {
+        return FALSE;
+    }
+    state.file_size = 0;
+    state.file_opened_time = platform_get_absolute_time();
+    state.file_flush_time = state.file_opened_time;
+    return TRUE;
+}
+
+static void log_file_flush()
+{
+    if (state.file_buffer_length && state.file.is_valid)
+    {
+        // Nowhere to report a failed write from here; the console still has the output.
+        platform_file_write(&state.file, state.file_buffer, state.file_buffer_length);
+        if (state.file_config.sync == LOG_FILE_SYNC_DATA)
+        {
+            platform_file_sync(&state.file);
+        }
+        state.file_size += state.file_buffer_length;
+    }
+    state.file_buffer_length = 0;
+    state.file_flush_requested = FALSE;
+    state.file_flush_time = platform_get_absolute_time();
+
+    bool8_t too_big = state.file_config.max_size && state.file_size >= state.file_config.max_size;
+    bool8_t too_old = state.file_config.max_age_seconds &&
+        state.file_flush_time - state.file_opened_time >= state.file_config.max_age_seconds;
+    if (state.file.is_valid && (too_big || too_old))
+    {
+        platform_file_close(&state.file);
+        log_file_open();
+    }
+}
+
+static void log_file_append(uint8_t level, const char* text, uint64_t length)
+{
+    if (!state.file.is_valid)
+    {
+        return;
+    }
+
+    if (state.file_buffer_length + length > LOG_FILE_BUFFER_SIZE)
+    {
+        log_file_flush();
+    }
+    platform_copy_memory(state.file_buffer + state.file_buffer_length, text, length);
+    state.file_buffer_length += length;
+
+    // Errors go out with this drain, in case they are the last thing the process does:
+    if (level < LOG_LEVEL_WARN)
+    {
+        state.file_flush_requested = TRUE;
+    }
+}
+
+static void log_batch_append(uint8_t level, const char* text, uint64_t length)
+{
+    log_file_append(level, text, length);
+
+    if (state.batch_length && (level != state.batch_level || state.batch_length + length > LOG_WRITE_BATCH_SIZE))
+    {
+        log_batch_emit();
+    }
+
+    state.batch_level = level;
+    platform_copy_memory(state.batch + state.batch_length, text, length);
+    state.batch_length += length;
+}
+
+static void log_binary_batch_emit()
+{
+    if (!state.binary_batch_length)
+    {
+        return;
+    }
+
+    if (!state.binary_file.is_valid && !state.binary_file_failed)
+    {
+        static const uint8_t header[8] = {'F', 'L', 'O', 'G', LOG_BINARY_VERSION, 0, 0, 0};
+        state.binary_file_failed = !platform_file_open(LOG_BINARY_FILE_PATH, FALSE, &state.binary_file) ||
+            !platform_file_write(&state.binary_file, header, sizeof(header));
+    }
+
+    if (state.binary_file.is_valid && !state.binary_file_failed)
+    {
+        state.binary_file_failed = !platform_file_write(&state.binary_file, state.binary_batch,
+            state.binary_batch_length);
+    }
+    state.binary_batch_length = 0;
+}
+
+static void log_binary_batch_append(const char* data, uint64_t length)
+{
+    if (state.binary_batch_length + length > LOG_WRITE_BATCH_SIZE)
+    {
+        log_binary_batch_emit();
+    }
+
+    platform_copy_memory(state.binary_batch + state.binary_batch_length, data, length);
+    state.binary_batch_length += length;
+}
+
+// Finds or claims the entry for a call site and locks it. Returns 0 if limiting is off, the table is full
+// around this key, or the entry is locked by another thread.
+static log_callsite* log_callsite_acquire(const char* format)
+{
+    if (!state.rate_burst)
+    {
+        return 0;
+    }
+
+    // Fibonacci hashing of the address; the low bits of string literal addresses carry little entropy.
+    uint64_t index = ((uint64_t)format * 0x9E3779B97F4A7C15ull) >> 54;
+    for (uint32_t probe = 0; probe < LOG_CALLSITE_MAX_PROBES; ++probe)
+    {
+        log_callsite* site = &state.callsites[(index + probe) & (LOG_CALLSITE_CAPACITY - 1)];
+        const char* key = atomic_load_explicit(&site->format, memory_order_acquire);
+        if (!key && atomic_compare_exchange_strong_explicit(&site->format, &key, format, memory_order_acq_rel,
+            memory_order_acquire))
+        {
+            key = format;
+        }
+
+        if (key == format)
+        {
+            return atomic_exchange_explicit(&site->locked, TRUE, memory_order_acquire) ? 0 : site;
+        }
+    }
+    return 0;
+}
+
+static void log_callsite_release(log_callsite* site)
+{
+    atomic_store_explicit(&site->locked, FALSE, memory_order_release);
+}
+
+/**
+ * Counts a message against its call site's rate limit.
+ * @returns FALSE if the message should be skipped. On TRUE, *out_site is the locked entry (or 0) and must be
+ * released with log_callsite_release.
+ */
+static bool8_t log_callsite_admit(const char* format, log_level level, float64_t now, log_callsite** out_site)
+{
+    *out_site = 0;
+    if (level == LOG_LEVEL_FATAL)
+    {
+        return TRUE;
+    }
+
+    log_callsite* site = log_callsite_acquire(format);
+    if (!site)
+    {
+        return TRUE;
+    }
+
+    site->level = (uint8_t)level;
+    if (now - site->window_start >= state.rate_window)
+    {
+        site->window_start = now;
+        site->window_count = 0;
+    }
+
+    if (site->window_count >= state.rate_burst)
+    {
+        site->suppressed++;
+        log_callsite_release(site);
+        return FALSE;
+    }
+
+    site->window_count++;
+    *out_site = site;
+    return TRUE;
+}
+
+// Appends the format string up to its first newline, shortened to LOG_SUMMARY_FORMAT_LENGTH:
+static void log_append_format_excerpt(string_builder* builder, const char* format)
+{
+    uint64_t length = 0;
+    while (format[length] && format[length] != '\n' && length < LOG_SUMMARY_FORMAT_LENGTH)
+    {
+        length++;
+    }
+    string_builder_append_char(builder, '"');
+    string_builder_append_view(builder, string_view_from(format, length));
+    string_builder_append(builder, format[length] && format[length] != '\n' ? "...\"" : "\"");
+}
+
+// Writer thread: reports the counts held back at every call site, once per window or when forced.
+static void log_callsites_sweep(bool8_t force)
+{
+    float64_t now = platform_get_absolute_time();
+    if (!force && now - state.last_sweep_time < state.rate_window)
+    {
+        return;
+    }
+    state.last_sweep_time = now;
+
+    // Fits the worst case, a repeat line and a suppression line each with a full excerpt, so the report is never
+    // grown on this thread:
+    char buffer[2 * (LOG_SUMMARY_FORMAT_LENGTH + 96)];
+    string_builder builder;
+    string_builder_create_from_buffer(buffer, sizeof(buffer), 0, &builder);
+
+    for (uint32_t i = 0; i < LOG_CALLSITE_CAPACITY; ++i)
+    {
+        log_callsite* site = &state.callsites[i];
+        const char* format = atomic_load_explicit(&site->format, memory_order_acquire);
+        if (!format || (!site->suppressed && !site->repeats) ||
+            atomic_exchange_explicit(&site->locked, TRUE, memory_order_acquire))
+        {
+            continue;
+        }
+
+        string_builder_clear(&builder);
+        if (site->repeats)
+        {
+            string_builder_append(&builder, level_strings[site->level]);
+            string_builder_append(&builder, "Last message from ");
+            log_append_format_excerpt(&builder, format);
+            string_builder_append_format(&builder, " repeated %u times.\n", site->repeats);
+        }
+        if (site->suppressed)
+        {
+            string_builder_append(&builder, level_strings[site->level]);
+            string_builder_append_format(&builder, "Rate limit: suppressed %u messages from ", site->suppressed);
+            log_append_format_excerpt(&builder, format);
+            string_builder_append(&builder, ".\n");
+        }
+        log_batch_append(site->level, builder.buffer, builder.length);
+
+        site->repeats = 0;
+        site->suppressed = 0;
+        log_callsite_release(site);
+    }
+
+    string_builder_destroy(&builder);
+}
+
+// Writes every published message to the console. Returns TRUE if anything was written.
+static bool8_t log_drain()
+{
+    bool8_t wrote = FALSE;
+
+    for (;;)
+    {
+        log_slot* first = &state.slots[state.read_position & (LOG_RING_SLOT_COUNT - 1)];
+        if (atomic_load_explicit(&first->sequence, memory_order_acquire) != state.read_position + 1)
+        {
+            break;
+        }
+
+        uint32_t slot_count = first->slot_count;
+        for (uint32_t i = 0; i < slot_count; ++i)
+        {
+            log_slot* slot = &state.slots[(state.read_position + i) & (LOG_RING_SLOT_COUNT - 1)];
+            if (first->level == LOG_RECORD_BINARY)
+            {
+                log_binary_batch_append(slot->text, slot->length);
+            }
+            else
+            {
+                log_batch_append(first->level, slot->text, slot->length);
+            }
+        }
+
+        // Release in position order: producers only check the last slot of the range they claim.
+        for (uint32_t i = 0; i < slot_count; ++i)
+        {
+            uint64_t position = state.read_position + i;
+            log_slot* slot = &state.slots[position & (LOG_RING_SLOT_COUNT - 1)];
+            atomic_store_explicit(&slot->sequence, position + LOG_RING_SLOT_COUNT, memory_order_release);
+        }
+
+        state.read_position += slot_count;
+        wrote = TRUE;
+    }
+
+    log_callsites_sweep(FALSE);
+
+    uint64_t dropped = atomic_exchange_explicit(&state.dropped_count, 0, memory_order_relaxed);
+    if (dropped)
+    {
+        char buffer[128];
+        string_builder builder;
+        string_builder_create_from_buffer(buffer, sizeof(buffer), 0, &builder);
+        string_builder_append_format(&builder, "[WARN]:  Log ring full, dropped %llu messages.\n", dropped);
+        log_batch_append(LOG_LEVEL_WARN, builder.buffer, builder.length);
+        wrote = TRUE;
+    }
+
+    log_batch_emit();
+    log_binary_batch_emit();
+    if (state.file_flush_requested ||
+        platform_get_absolute_time() - state.file_flush_time >= state.file_config.flush_interval_ms * 0.001)
+    {
+        log_file_flush();
+    }
+    atomic_store_explicit(&state.flushed_position, state.read_position, memory_order_release);
+    return wrote;
+}
+
+static uint32_t log_writer_thread(void* params)
+{
+    while (atomic_load(&state.running))
+    {
+        if (log_drain())
+        {
+            continue;
+        }
+
+        // Announce the sleep before the final check so a producer that publishes in between signals us:
+        atomic_store(&state.writer_sleeping, TRUE);
+        log_slot* next = &state.slots[state.read_position & (LOG_RING_SLOT_COUNT - 1)];
+        if (atomic_load(&next->sequence) != state.read_position + 1 && atomic_load(&state.running))
+        {
+            platform_semaphore_wait(&state.wake, LOG_WRITER_IDLE_WAIT_MS);
+        }
+        atomic_store(&state.writer_sleeping, FALSE);
+    }
+
+    log_drain();
+    log_callsites_sweep(TRUE);
+    log_batch_emit();
+    log_file_flush();
+    platform_file_close(&state.file);
+    platform_file_close(&state.binary_file);
+    return 0;
+}
+
+// Copies a formatted message into the ring. Returns FALSE if the ring is full.
+static bool8_t log_enqueue(log_level level, const char* text, uint64_t length)
+{
+    uint64_t slot_count = length ? (length + LOG_SLOT_TEXT_SIZE - 1) / LOG_SLOT_TEXT_SIZE : 1;
+    if (slot_count > LOG_RING_MAX_SLOTS_PER_MESSAGE)
+    {
+        slot_count = LOG_RING_MAX_SLOTS_PER_MESSAGE;
+        length = slot_count * LOG_SLOT_TEXT_SIZE;
+    }
+
+    // Claim slot_count consecutive positions. The writer releases slots in order, so if the last one is free
+    // the ones before it are too:
+    uint64_t position = atomic_load_explicit(&state.write_position, memory_order_relaxed);
+    for (;;)
+    {
+        uint64_t last = position + slot_count - 1;
+        uint64_t sequence = atomic_load_explicit(&state.slots[last & (LOG_RING_SLOT_COUNT - 1)].sequence,
+            memory_order_acquire);
+        int64_t difference = (int64_t)(sequence - last);
+
+        if (difference == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&state.write_position, &position, position + slot_count,
+                memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            return FALSE;
+        }
+        else
+        {
+            position = atomic_load_explicit(&state.write_position, memory_order_relaxed);
+        }
+    }
+
+    uint64_t offset = 0;
+    for (uint64_t i = 0; i < slot_count; ++i)
+    {
+        log_slot* slot = &state.slots[(position + i) & (LOG_RING_SLOT_COUNT - 1)];
+        uint64_t chunk = length - offset < LOG_SLOT_TEXT_SIZE ? length - offset : LOG_SLOT_TEXT_SIZE;
+        platform_copy_memory(slot->text, text + offset, chunk);
+        slot->length = (uint16_t)chunk;
+        offset += chunk;
+    }
+
+    // Publishing the first slot publishes the whole message:
+    log_slot* first = &state.slots[position & (LOG_RING_SLOT_COUNT - 1)];
+    first->level = (uint8_t)level;
+    first->slot_count = (uint8_t)slot_count;
+    atomic_store_explicit(&first->sequence, position + 1, memory_order_release);
+
+    // Pairs with the writer's store to writer_sleeping before its last check of the ring:
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&state.writer_sleeping, memory_order_relaxed))
+    {
+        platform_semaphore_signal(&state.wake);
+    }
+    return TRUE;
+}
+
+// Waits until everything queued before the call has been written, or until timeout_ms elapses.
+static void log_flush(uint64_t timeout_ms)
+{
+    uint64_t target = atomic_load(&state.write_position);
+    platform_semaphore_signal(&state.wake);
+
+    float64_t deadline = platform_get_absolute_time() + timeout_ms * 0.001;
+    while (atomic_load_explicit(&state.flushed_position, memory_order_acquire) < target)
+    {
+        if (platform_get_absolute_time() >= deadline)
+        {
+            return;
+        }
+        platform_sleep(1);
+    }
+}
+
+/*
+ * Binary logging.
+ *
+ * Records are packed without padding:
+ *   format:  u8 LOG_BINARY_RECORD_FORMAT, u32 id, u8 level, u16 length, format bytes
+ *   message: u8 LOG_BINARY_RECORD_MESSAGE, u32 id, u32 thread, f64 timestamp, u16 argument size, arguments
+ * Integer arguments are stored as 8 bytes after the hh/h truncation printf would apply, floats and pointers
+ * as 8 bytes, '*' widths and precisions as 4 bytes, and strings as a u16 length followed by at most
+ * LOG_BINARY_MAX_STRING bytes.
+ *
+ * Each thread fills its own buffer and hands it to the writer thread as one ring message when it is full, so
+ * records from different threads arrive in chunks. The decoder reads every format record before decoding
+ * messages and sorts messages by timestamp.
+ */
+
+#define LOG_BINARY_RECORD_FORMAT 1
+#define LOG_BINARY_RECORD_MESSAGE 2
+#define LOG_BINARY_FORMAT_HEADER_SIZE (1 + 4 + 1 + 2)
+#define LOG_BINARY_MESSAGE_HEADER_SIZE (1 + 4 + 4 + 8 + 2)
+
+#define LOG_BINARY_MAX_FORMATS 4096
+#define LOG_BINARY_MAX_FORMAT_LENGTH 1024
+#define LOG_BINARY_MAX_ARGS 16
+#define LOG_BINARY_MAX_STRING 400
+#define LOG_BINARY_BUFFER_SIZE 8192
+
+// Call sites whose format can't be recorded are marked with this id and log as text:
+#define LOG_BINARY_TEXT_FALLBACK 0xFFFFFFFF
+
+STATIC_ASSERT(LOG_BINARY_MESSAGE_HEADER_SIZE + LOG_BINARY_MAX_ARGS * (2 + LOG_BINARY_MAX_STRING) <=
+    LOG_BINARY_BUFFER_SIZE, "Expected the largest message record to fit in a binary log buffer.");
+STATIC_ASSERT(LOG_BINARY_FORMAT_HEADER_SIZE + LOG_BINARY_MAX_FORMAT_LENGTH <= LOG_BINARY_BUFFER_SIZE,
+    "Expected the largest format record to fit in a binary log buffer.");
+STATIC_ASSERT(LOG_BINARY_BUFFER_SIZE <= LOG_RING_MAX_SLOTS_PER_MESSAGE * LOG_SLOT_TEXT_SIZE,
+    "Expected a binary log buffer to fit in a single ring message.");
+
+typedef enum log_arg_kind
+{
+    // int width or precision:
+    LOG_ARG_STAR,
+    LOG_ARG_INT,
+    LOG_ARG_UINT,
+    LOG_ARG_CHAR,
+    LOG_ARG_UCHAR,
+    LOG_ARG_SHORT,
+    LOG_ARG_USHORT,
+    LOG_ARG_LONG,
+    LOG_ARG_ULONG,
+    // ll, j, z and t:
+    LOG_ARG_INT64,
+    LOG_ARG_FLOAT64,
+    LOG_ARG_STRING,
+    LOG_ARG_POINTER
+} log_arg_kind;
+
+typedef struct log_binary_format
+{
+    uint8_t arg_kinds[LOG_BINARY_MAX_ARGS];
+    uint32_t arg_count;
+    // Worst-case size of a message record using this format:
+    uint32_t max_record_size;
+} log_binary_format;
+
+typedef struct log_binary_buffer
+{
+    uint8_t data[LOG_BINARY_BUFFER_SIZE];
+    uint32_t length;
+    uint32_t thread_id;
+} log_binary_buffer;
+
+static _Thread_local log_binary_buffer binary_buffer;
+
+// One printf conversion, as split up by log_format_next:
+typedef struct log_format_spec
+{
+    // From the '%' to one past the conversion character:
+    const char* start;
+    const char* end;
+    // Flags are [start + 1, flags_end), the width is [flags_end, width_end):
+    const char* flags_end;
+    const char* width_end;
+    // 0 if there is no precision, otherwise the text after the '.':
+    const char* precision_start;
+    const char* precision_end;
+    bool8_t star_width;
+    bool8_t star_precision;
+    // 0, 'H' (hh), 'h', 'l', 'q' (ll), 'j', 'z', 't' or 'L':
+    char length;
+    char conversion;
+} log_format_spec;
+
+// Finds the next conversion at or after cursor. Returns FALSE if there is none. "%%" has conversion '%'.
+static bool8_t log_format_next(const char* cursor, log_format_spec* out_spec)
+{
+    while (*cursor && *cursor != '%')
+    {
+        cursor++;
+    }
+    if (!*cursor)
+    {
+        return FALSE;
+    }
+
+    out_spec->start = cursor++;
+    while (*cursor == '-' || *cursor == '0' || *cursor == '+' || *cursor == ' ' || *cursor == '#')
+    {
+        cursor++;
+    }
+    out_spec->flags_end = cursor;
+
+    out_spec->star_width = *cursor == '*';
+    if (out_spec->star_width)
+    {
+        cursor++;
+    }
+    while (*cursor >= '0' && *cursor <= '9')
+    {
+        cursor++;
+    }
+    out_spec->width_end = cursor;
+
+    out_spec->precision_start = 0;
+    out_spec->precision_end = 0;
+    out_spec->star_precision = FALSE;
+    if (*cursor == '.')
+    {
+        out_spec->precision_start = ++cursor;
+        out_spec->star_precision = *cursor == '*';
+        if (out_spec->star_precision)
+        {
+            cursor++;
+        }
+        while (*cursor >= '0' && *cursor <= '9')
+        {
+            cursor++;
+        }
+        out_spec->precision_end = cursor;
+    }
+
+    out_spec->length = 0;
+    if (*cursor == 'h')
+    {
+        out_spec->length = *++cursor == 'h' ? (cursor++, 'H') : 'h';
+    }
+    else if (*cursor == 'l')
+    {
+        out_spec->length = *++cursor == 'l' ? (cursor++, 'q') : 'l';
+    }
+    else if (*cursor == 'j' || *cursor == 'z' || *cursor == 't' || *cursor == 'L')
+    {
+        out_spec->length = *cursor++;
+    }
+
+    out_spec->conversion = *cursor;
+    if (*cursor)
+    {
+        cursor++;
+    }
+    out_spec->end = cursor;
+    return TRUE;
+}
+
+// Appends the kinds of the arguments a conversion consumes. Returns FALSE if the conversion can't be recorded.
+static bool8_t log_format_arg_kinds(const log_format_spec* spec, uint8_t* kinds, uint32_t* count)
+{
+    if (spec->conversion == '%')
+    {
+        return TRUE;
+    }
+    if (*count + 3 > LOG_BINARY_MAX_ARGS)
+    {
+        return FALSE;
+    }
+
+    if (spec->star_width)
+    {
+        kinds[(*count)++] = LOG_ARG_STAR;
+    }
+    if (spec->star_precision)
+    {
+        kinds[(*count)++] = LOG_ARG_STAR;
+    }
+
+    switch (spec->conversion)
+    {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        {
+            bool8_t is_signed = spec->conversion == 'd' || spec->conversion == 'i';
+            switch (spec->length)
+            {
+                case 0: kinds[(*count)++] = is_signed ? LOG_ARG_INT : LOG_ARG_UINT; break;
+                case 'H': kinds[(*count)++] = is_signed ? LOG_ARG_CHAR : LOG_ARG_UCHAR; break;
+                case 'h': kinds[(*count)++] = is_signed ? LOG_ARG_SHORT : LOG_ARG_USHORT; break;
+                case 'l': kinds[(*count)++] = is_signed ? LOG_ARG_LONG : LOG_ARG_ULONG; break;
+                case 'L': return FALSE;
+                default: kinds[(*count)++] = LOG_ARG_INT64; break;
+            }
+            return TRUE;
+        }
+        case 'c':
+            kinds[(*count)++] = LOG_ARG_INT;
+            return spec->length == 0;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            kinds[(*count)++] = LOG_ARG_FLOAT64;
+            return spec->length != 'L';
+        case 's':
+            kinds[(*count)++] = LOG_ARG_STRING;
+            return spec->length == 0;
+        case 'p':
+            kinds[(*count)++] = LOG_ARG_POINTER;
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static uint32_t log_arg_max_size(uint8_t kind)
+{
+    switch (kind)
+    {
+        case LOG_ARG_STAR: return sizeof(int32_t);
+        case LOG_ARG_STRING: return sizeof(uint16_t) + LOG_BINARY_MAX_STRING;
+        default: return sizeof(uint64_t);
+    }
+}
+
+// Small fixed-size stores; __builtin_memcpy lets the compiler turn these into plain moves.
+static inline uint8_t* log_binary_put(uint8_t* cursor, const void* value, uint64_t size)
+{
+    __builtin_memcpy(cursor, value, size);
+    return cursor + size;
+}
+
+static void log_binary_flush_buffer(log_binary_buffer* buffer)
+{
+    if (!buffer->length)
+    {
+        return;
+    }
+
+    if (!atomic_load_explicit(&state.running, memory_order_relaxed) ||
+        !log_enqueue((log_level)LOG_RECORD_BINARY, (const char*)buffer->data, buffer->length))
+    {
+        atomic_fetch_add_explicit(&state.dropped_count, 1, memory_order_relaxed);
+    }
+    buffer->length = 0;
+}
+
+// Makes room for a record of up to size bytes in the calling thread's buffer:
+static log_binary_buffer* log_binary_reserve(uint32_t size)
+{
+    log_binary_buffer* buffer = &binary_buffer;
+    if (!buffer->thread_id)
+    {
+        buffer->thread_id = atomic_fetch_add_explicit(&state.binary_thread_count, 1, memory_order_relaxed) + 1;
+    }
+    if (buffer->length + size > LOG_BINARY_BUFFER_SIZE)
+    {
+        log_binary_flush_buffer(buffer);
+    }
+    return buffer;
+}
+
+static uint32_t log_binary_register(uint32_t* format_id, log_level level, const char* format)
+{
+    // Before initialize_logging there is no format table yet. Fall back to text for this call only, so the call
+    // site registers properly once the logger is up:
+    if (!state.binary_formats)
+    {
+        return LOG_BINARY_TEXT_FALLBACK;
+    }
+
+    log_binary_format entry = {0};
+    uint64_t format_length = string_length(format);
+    bool8_t supported = format_length <= LOG_BINARY_MAX_FORMAT_LENGTH;
+
+    log_format_spec spec;
+    for (const char* cursor = format; supported && log_format_next(cursor, &spec); cursor = spec.end)
+    {
+        supported = log_format_arg_kinds(&spec, entry.arg_kinds, &entry.arg_count);
+    }
+
+    uint32_t id = LOG_BINARY_TEXT_FALLBACK;
+    if (supported)
+    {
+        id = atomic_fetch_add_explicit(&state.binary_format_count, 1, memory_order_relaxed) + 1;
+        if (id >= LOG_BINARY_MAX_FORMATS)
+        {
+            id = LOG_BINARY_TEXT_FALLBACK;
+        }
+    }
+
+    if (id != LOG_BINARY_TEXT_FALLBACK)
+    {
+        entry.max_record_size = LOG_BINARY_MESSAGE_HEADER_SIZE;
+        for (uint32_t i = 0; i < entry.arg_count; ++i)
+        {
+            entry.max_record_size += log_arg_max_size(entry.arg_kinds[i]);
+        }
+        state.binary_formats[id] = entry;
+
+        log_binary_buffer* buffer = log_binary_reserve(LOG_BINARY_FORMAT_HEADER_SIZE + (uint32_t)format_length);
+        uint8_t* cursor = buffer->data + buffer->length;
+        uint8_t type = LOG_BINARY_RECORD_FORMAT;
+        uint8_t level_byte = (uint8_t)level;
+        uint16_t length = (uint16_t)format_length;
+        cursor = log_binary_put(cursor, &type, sizeof(type));
+        cursor = log_binary_put(cursor, &id, sizeof(id));
+        cursor = log_binary_put(cursor, &level_byte, sizeof(level_byte));
+        cursor = log_binary_put(cursor, &length, sizeof(length));
+        platform_copy_memory(cursor, format, format_length);
+        buffer->length += LOG_BINARY_FORMAT_HEADER_SIZE + (uint32_t)format_length;
+    }
+
+    // Another thread may have registered the same call site in the meantime; the first id published wins.
+    uint32_t expected = 0;
+    if (!__atomic_compare_exchange_n(format_id, &expected, id, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        return expected;
+    }
+    return id;
+}
+
+void log_set_category_level(log_category category, log_level level)
+{
+    if (category < LOG_CATEGORY_MAX)
+    {
+        log_category_levels[category] = (uint8_t)level;
+    }
+}
+
+log_level log_get_category_level(log_category category)
+{
+    return category < LOG_CATEGORY_MAX ? (log_level)log_category_levels[category] : LOG_LEVEL_TRACE;
+}
+
+void log_set_level(log_level level)
+{
+    for (uint32_t i = 0; i < LOG_CATEGORY_MAX; ++i)
+    {
+        log_category_levels[i] = (uint8_t)level;
+    }
+}
+
+void log_set_rate_limit(uint32_t burst, float64_t window_seconds)
+{
+    state.rate_burst = burst;
+    state.rate_window = window_seconds > 0 ? window_seconds : LOG_DEFAULT_RATE_WINDOW;
+}
+
+void log_file_configure(const log_file_config* config)
+{
+    state.file_config = *config;
+}
 
 bool8_t initialize_logging()
 {
-    // TODO: create log file.
+    for (uint64_t i = 0; i < LOG_RING_SLOT_COUNT; ++i)
+    {
+        atomic_init(&state.slots[i].sequence, i);
+    }
+    atomic_init(&state.write_position, 0);
+    atomic_init(&state.flushed_position, 0);
+    atomic_init(&state.dropped_count, 0);
+    atomic_init(&state.writer_sleeping, FALSE);
+    state.read_position = 0;
+    state.batch_length = 0;
+    state.binary_batch_length = 0;
+    state.binary_file_failed = FALSE;
+    atomic_init(&state.binary_format_count, 0);
+    atomic_init(&state.binary_thread_count, 0);
+    if (!state.binary_formats)
+    {
+        state.binary_formats = platform_allocate(sizeof(log_binary_format) * LOG_BINARY_MAX_FORMATS, FALSE);
+    }
+
+    if (!platform_semaphore_create(0, &state.wake))
+    {
+        return FALSE;
+    }
+
+    // Opened here rather than on the writer thread so a failure is reported right away:
+    state.file_buffer_length = 0;
+    state.file_flush_requested = FALSE;
+    state.file.is_valid = FALSE;
+    if (state.file_config.path)
+    {
+        string_builder path;
+        string_builder_create_from_buffer(state.file_path, sizeof(state.file_path), 0, &path);
+        string_builder_append(&path, state.file_config.path);
+        if (path.buffer != state.file_path)
+        {
+            FWARN("Log file path too long; logging to console only.");
+        }
+        else
+        {
+            log_file_open();
+        }
+        string_builder_destroy(&path);
+    }
+
+    atomic_store(&state.running, TRUE);
+    if (!platform_thread_create(log_writer_thread, 0, &state.writer))
+    {
+        // Keep logging synchronously on the calling thread:
+        atomic_store(&state.running, FALSE);
+        platform_semaphore_destroy(&state.wake);
+        platform_file_close(&state.file);
+        FWARN("Failed to start the log writer thread. Logging synchronously to the console only.");
+    }
+
     return TRUE;
 }
 
 void shutdown_logging()
 {
-    // TODO: cleanup logging/write queued entries.
+    if (!atomic_load(&state.running))
+    {
+        return;
+    }
+
+    log_binary_flush_thread();
+
+    // The writer drains everything still queued before it exits:
+    atomic_store(&state.running, FALSE);
+    platform_semaphore_signal(&state.wake);
+    platform_thread_join(&state.writer);
+    platform_semaphore_destroy(&state.wake);
 }
 
-void log_output(log_level level, const char* message, ...) {
-    const char* level_strings[6] = {"[FATAL]: ", "[ERROR]: ", "[WARN]:  ", "[INFO]:  ", "[DEBUG]: ", "[TRACE]: "};
-    bool8_t is_error = level < LOG_LEVEL_WARN;
+static void log_output_v(log_level level, const char* message, __builtin_va_list args)
+{
+    // Rate limited messages are dropped here, before any formatting:
+    log_callsite* site;
+    if (!log_callsite_admit(message, level, platform_get_absolute_time(), &site))
+    {
+        return;
+    }
+
+    // Single formatting pass: prefix, message and newline are appended straight into one buffer.
+    char stack_buffer[LOG_STACK_BUFFER_SIZE];
+    string_builder builder;
+    string_builder_create_from_buffer(stack_buffer, sizeof(stack_buffer), 0, &builder);
+    string_builder_append(&builder, level_strings[level]);
+    string_builder_append_format_v(&builder, message, args);
+    string_builder_append_char(&builder, '\n');
+
+    if (site)
+    {
+        // Collapse a message identical to the call site's previous one into a count:
+        uint32_t hash = string_hash(builder.buffer, builder.length);
+        bool8_t repeated = site->window_count > 1 && hash == site->last_hash;
+        site->last_hash = hash;
+        if (repeated)
+        {
+            site->repeats++;
+        }
+        log_callsite_release(site);
+
+        if (repeated)
+        {
+            string_builder_destroy(&builder);
+            return;
+        }
+    }
+
+    // A fatal message is usually followed by the process going down; binary records logged before it go first:
+    if (level == LOG_LEVEL_FATAL)
+    {
+        log_binary_flush_thread();
+    }
 
-    // Technically imposes a 32k character limit on a single log entry, but...
-    // DON'T DO THAT!
-    const int32_t msg_length = 32000;
-    char out_message[msg_length];
-    memset(out_message, 0, sizeof(out_message));
+    if (!atomic_load_explicit(&state.running, memory_order_relaxed))
+    {
+        // Before initialize_logging/after shutdown_logging:
+        log_write_console(level, string_builder_cstr(&builder));
+    }
+    else if (!log_enqueue(level, builder.buffer, builder.length))
+    {
+        // Ring full. Errors are never dropped: wait a bounded time for room, then write them out directly (to the
+        // console only, possibly ahead of queued messages):
+        if (level < LOG_LEVEL_WARN)
+        {
+            float64_t deadline = platform_get_absolute_time() + LOG_FATAL_FLUSH_TIMEOUT_MS * 0.001;
+            bool8_t queued = FALSE;
+            while (!queued && platform_get_absolute_time() < deadline)
+            {
+                platform_semaphore_signal(&state.wake);
+                platform_sleep(1);
+                queued = log_enqueue(level, builder.buffer, builder.length);
+            }
+            if (!queued)
+            {
+                log_write_console(level, string_builder_cstr(&builder));
+            }
+        }
+        else
+        {
+            atomic_fetch_add_explicit(&state.dropped_count, 1, memory_order_relaxed);
+        }
+    }
+
+    // Get the fatal message and everything queued before it out:
+    if (level == LOG_LEVEL_FATAL && atomic_load_explicit(&state.running, memory_order_relaxed))
+    {
+        log_flush(LOG_FATAL_FLUSH_TIMEOUT_MS);
+    }
+
+    string_builder_destroy(&builder);
+}
 
-    // Format original message.
+void log_output(log_level level, const char* message, ...) {
     __builtin_va_list arg_ptr;
     va_start(arg_ptr, message);
-    vsnprintf(out_message, msg_length, message, arg_ptr);
+    log_output_v(level, message, arg_ptr);
     va_end(arg_ptr);
+}
+
+// Counts the bytes of str that are recorded, without reading past LOG_BINARY_MAX_STRING:
+static uint16_t log_binary_string_length(const char* str)
+{
+    uint16_t length = 0;
+    while (length < LOG_BINARY_MAX_STRING && str[length])
+    {
+        length++;
+    }
+    return length;
+}
+
+void log_binary_output(uint32_t* format_id, log_level level, const char* format, ...)
+{
+    uint32_t id = __atomic_load_n(format_id, __ATOMIC_ACQUIRE);
+    if (!id)
+    {
+        id = log_binary_register(format_id, level, format);
+    }
 
-    char out_message2[msg_length];
-    sprintf(out_message2, "%s%s\n", level_strings[level], out_message);
+    __builtin_va_list args;
+    va_start(args, format);
 
-    // Platform-specific output.
-    if (is_error) {
-        platform_console_write_error(out_message2, level);
-    } else {
-        platform_console_write(out_message2, level);
+    if (id == LOG_BINARY_TEXT_FALLBACK)
+    {
+        log_output_v(level, format, args);
+        va_end(args);
+        return;
+    }
+
+    float64_t timestamp = platform_get_absolute_time();
+    log_callsite* site;
+    if (!log_callsite_admit(format, level, timestamp, &site))
+    {
+        va_end(args);
+        return;
+    }
+    if (site)
+    {
+        log_callsite_release(site);
+    }
+
+    const log_binary_format* entry = &state.binary_formats[id];
+    log_binary_buffer* buffer = log_binary_reserve(entry->max_record_size);
+    uint8_t* record = buffer->data + buffer->length;
+    uint8_t* cursor = record + LOG_BINARY_MESSAGE_HEADER_SIZE;
+
+    for (uint32_t i = 0; i < entry->arg_count; ++i)
+    {
+        int64_t value = 0;
+        switch (entry->arg_kinds[i])
+        {
+            case LOG_ARG_STAR:
+            {
+                int32_t star = va_arg(args, int32_t);
+                cursor = log_binary_put(cursor, &star, sizeof(star));
+                continue;
+            }
+            case LOG_ARG_FLOAT64:
+            {
+                float64_t f = va_arg(args, float64_t);
+                cursor = log_binary_put(cursor, &f, sizeof(f));
+                continue;
+            }
+            case LOG_ARG_STRING:
+            {
+                const char* str = va_arg(args, const char*);
+                if (!str)
+                {
+                    str = "(null)";
+                }
+                uint16_t length = log_binary_string_length(str);
+                cursor = log_binary_put(cursor, &length, sizeof(length));
+                platform_copy_memory(cursor, str, length);
+                cursor += length;
+                continue;
+            }
+            case LOG_ARG_INT: value = va_arg(args, int32_t); break;
+            case LOG_ARG_UINT: value = va_arg(args, uint32_t); break;
+            case LOG_ARG_CHAR: value = (int8_t)va_arg(args, int32_t); break;
+            case LOG_ARG_UCHAR: value = (uint8_t)va_arg(args, int32_t); break;
+            case LOG_ARG_SHORT: value = (int16_t)va_arg(args, int32_t); break;
+            case LOG_ARG_USHORT: value = (uint16_t)va_arg(args, int32_t); break;
+            case LOG_ARG_LONG: value = va_arg(args, long); break;
+            case LOG_ARG_ULONG: value = (int64_t)va_arg(args, unsigned long); break;
+            case LOG_ARG_INT64: value = va_arg(args, int64_t); break;
+            case LOG_ARG_POINTER: value = (int64_t)(uint64_t)va_arg(args, const void*); break;
+        }
+        cursor = log_binary_put(cursor, &value, sizeof(value));
     }
+    va_end(args);
+
+    uint8_t type = LOG_BINARY_RECORD_MESSAGE;
+    uint16_t args_size = (uint16_t)(cursor - record - LOG_BINARY_MESSAGE_HEADER_SIZE);
+    uint8_t* header = record;
+    header = log_binary_put(header, &type, sizeof(type));
+    header = log_binary_put(header, &id, sizeof(id));
+    header = log_binary_put(header, &buffer->thread_id, sizeof(buffer->thread_id));
+    header = log_binary_put(header, &timestamp, sizeof(timestamp));
+    log_binary_put(header, &args_size, sizeof(args_size));
+
+    buffer->length = (uint32_t)(cursor - buffer->data);
+}
+
+void log_binary_flush_thread()
+{
+    log_binary_flush_buffer(&binary_buffer);
+}
+
+// -- Decoding --
+
+typedef struct log_binary_record
+{
+    uint8_t type;
+    uint8_t level;
+    uint32_t id;
+    uint32_t thread_id;
+    float64_t timestamp;
+    const uint8_t* payload;
+    uint64_t payload_size;
+} log_binary_record;
+
+typedef struct log_decoded_format
+{
+    const char* format;
+    uint8_t level;
+} log_decoded_format;
+
+typedef struct log_decoded_message
+{
+    float64_t timestamp;
+    uint64_t offset;
+} log_decoded_message;
+
+// Bounds-checked read of size bytes at *offset:
+static bool8_t log_binary_read(const uint8_t* data, uint64_t size, uint64_t* offset, void* out, uint64_t count)
+{
+    if (*offset + count > size)
+    {
+        return FALSE;
+    }
+    platform_copy_memory(out, data + *offset, count);
+    *offset += count;
+    return TRUE;
+}
+
+// Reads the record at *offset. Returns FALSE at the end of the data or at a truncated record.
+static bool8_t log_binary_next_record(const uint8_t* data, uint64_t size, uint64_t* offset,
+    log_binary_record* out_record)
+{
+    uint64_t cursor = *offset;
+    if (!log_binary_read(data, size, &cursor, &out_record->type, 1) ||
+        !log_binary_read(data, size, &cursor, &out_record->id, 4))
+    {
+        return FALSE;
+    }
+
+    uint16_t payload_size = 0;
+    if (out_record->type == LOG_BINARY_RECORD_FORMAT)
+    {
+        if (!log_binary_read(data, size, &cursor, &out_record->level, 1) ||
+            !log_binary_read(data, size, &cursor, &payload_size, 2))
+        {
+            return FALSE;
+        }
+    }
+    else if (out_record->type == LOG_BINARY_RECORD_MESSAGE)
+    {
+        if (!log_binary_read(data, size, &cursor, &out_record->thread_id, 4) ||
+            !log_binary_read(data, size, &cursor, &out_record->timestamp, 8) ||
+            !log_binary_read(data, size, &cursor, &payload_size, 2))
+        {
+            return FALSE;
+        }
+    }
+    else
+    {
+        return FALSE;
+    }
+
+    if (cursor + payload_size > size)
+    {
+        return FALSE;
+    }
+    out_record->payload = data + cursor;
+    out_record->payload_size = payload_size;
+    *offset = cursor + payload_size;
+    return TRUE;
+}
+
+// Formats one message from its recorded arguments, re-deriving the argument layout from the format.
+static void log_binary_format_message(string_builder* out, const char* format, const uint8_t* args,
+    uint64_t args_size)
+{
+    uint64_t offset = 0;
+    bool8_t truncated = FALSE;
+    const char* cursor = format;
+    log_format_spec spec;
+    while (log_format_next(cursor, &spec))
+    {
+        string_builder_append_view(out, string_view_from(cursor, (uint64_t)(spec.start - cursor)));
+        cursor = spec.end;
+
+        if (spec.conversion == '%')
+        {
+            string_builder_append_char(out, '%');
+            continue;
+        }
+
+        uint8_t kinds[LOG_BINARY_MAX_ARGS];
+        uint32_t count = 0;
+        if (!log_format_arg_kinds(&spec, kinds, &count))
+        {
+            string_builder_append(out, "<unsupported conversion>");
+            return;
+        }
+
+        // Rebuild the conversion with '*' resolved and every integer read as 64 bits:
+        char spec_buffer[64];
+        string_builder spec_text;
+        string_builder_create_from_buffer(spec_buffer, sizeof(spec_buffer), 0, &spec_text);
+        string_builder_append_char(&spec_text, '%');
+        string_builder_append_view(&spec_text,
+            string_view_from(spec.start + 1, (uint64_t)(spec.flags_end - spec.start - 1)));
+
+        uint32_t kind_index = 0;
+        if (spec.star_width)
+        {
+            int32_t width = 0;
+            if (!log_binary_read(args, args_size, &offset, &width, sizeof(width)))
+            {
+                truncated = TRUE;
+                break;
+            }
+            kind_index++;
+            if (width < 0)
+            {
+                string_builder_append_char(&spec_text, '-');
+                width = -width;
+            }
+            string_builder_append_u64(&spec_text, (uint64_t)width);
+        }
+        else
+        {
+            string_builder_append_view(&spec_text,
+                string_view_from(spec.flags_end, (uint64_t)(spec.width_end - spec.flags_end)));
+        }
+
+        if (spec.precision_start)
+        {
+            if (spec.star_precision)
+            {
+                int32_t precision = 0;
+                if (!log_binary_read(args, args_size, &offset, &precision, sizeof(precision)))
+                {
+                    truncated = TRUE;
+                    break;
+                }
+                kind_index++;
+                // A negative precision is taken as if it were omitted:
+                if (precision >= 0)
+                {
+                    string_builder_append_char(&spec_text, '.');
+                    string_builder_append_u64(&spec_text, (uint64_t)precision);
+                }
+            }
+            else
+            {
+                string_builder_append_char(&spec_text, '.');
+                string_builder_append_view(&spec_text,
+                    string_view_from(spec.precision_start, (uint64_t)(spec.precision_end - spec.precision_start)));
+            }
+        }
+
+        bool8_t read = TRUE;
+        switch (kinds[kind_index])
+        {
+            case LOG_ARG_FLOAT64:
+            {
+                float64_t value = 0;
+                read = log_binary_read(args, args_size, &offset, &value, sizeof(value));
+                string_builder_append_char(&spec_text, spec.conversion);
+                if (read)
+                {
+                    string_builder_append_format(out, string_builder_cstr(&spec_text), value);
+                }
+            }
+            break;
+            case LOG_ARG_STRING:
+            {
+                uint16_t length = 0;
+                char str[LOG_BINARY_MAX_STRING + 1];
+                read = log_binary_read(args, args_size, &offset, &length, sizeof(length)) &&
+                    length <= LOG_BINARY_MAX_STRING && log_binary_read(args, args_size, &offset, str, length);
+                string_builder_append_char(&spec_text, 's');
+                if (read)
+                {
+                    str[length] = 0;
+                    string_builder_append_format(out, string_builder_cstr(&spec_text), str);
+                }
+            }
+            break;
+            default:
+            {
+                int64_t value = 0;
+                read = log_binary_read(args, args_size, &offset, &value, sizeof(value));
+                if (spec.conversion == 'c')
+                {
+                    string_builder_append_char(&spec_text, 'c');
+                    if (read)
+                    {
+                        string_builder_append_format(out, string_builder_cstr(&spec_text), (int32_t)value);
+                    }
+                }
+                else if (spec.conversion == 'p')
+                {
+                    string_builder_append_char(&spec_text, 'p');
+                    if (read)
+                    {
+                        string_builder_append_format(out, string_builder_cstr(&spec_text), (void*)(uint64_t)value);
+                    }
+                }
+                else
+                {
+                    string_builder_append(&spec_text, "ll");
+                    string_builder_append_char(&spec_text, spec.conversion);
+                    if (read)
+                    {
+                        string_builder_append_format(out, string_builder_cstr(&spec_text), value);
+                    }
+                }
+            }
+            break;
+        }
+        string_builder_destroy(&spec_text);
+
+        if (!read)
+        {
+            truncated = TRUE;
+            break;
+        }
+    }
+
+    if (truncated)
+    {
+        string_builder_append(out, "<truncated>");
+        return;
+    }
+    string_builder_append(out, cursor);
+}
+
+// Stable bottom-up merge sort by timestamp:
+static void log_decoded_messages_sort(log_decoded_message* messages, log_decoded_message* scratch, uint64_t count)
+{
+    log_decoded_message* source = messages;
+    log_decoded_message* dest = scratch;
+    for (uint64_t width = 1; width < count; width *= 2)
+    {
+        for (uint64_t start = 0; start < count; start += 2 * width)
+        {
+            uint64_t middle = start + width < count ? start + width : count;
+            uint64_t end = start + 2 * width < count ? start + 2 * width : count;
+            uint64_t left = start;
+            uint64_t right = middle;
+            for (uint64_t i = start; i < end; ++i)
+            {
+                if (left < middle && (right >= end || source[left].timestamp <= source[right].timestamp))
+                {
+                    dest[i] = source[left++];
+                }
+                else
+                {
+                    dest[i] = source[right++];
+                }
+            }
+        }
+        log_decoded_message* swap = source;
+        source = dest;
+        dest = swap;
+    }
+
+    if (source != messages)
+    {
+        platform_copy_memory(messages, source, sizeof(log_decoded_message) * count);
+    }
+}
+
+bool8_t log_binary_decode(const uint8_t* data, uint64_t size, string_builder* out_text)
+{
+    if (size < 8 || data[0] != 'F' || data[1] != 'L' || data[2] != 'O' || data[3] != 'G')
+    {
+        FERROR("log_binary_decode - Not a binary log.");
+        return FALSE;
+    }
+    if (data[4] != LOG_BINARY_VERSION)
+    {
+        FERROR("log_binary_decode - Unsupported binary log version %u.", data[4]);
+        return FALSE;
+    }
+
+    // First pass: size the tables. A truncated tail (e.g. after a crash) ends the log.
+    uint32_t max_id = 0;
+    uint64_t message_count = 0;
+    uint64_t offset = 8;
+    log_binary_record record;
+    while (log_binary_next_record(data, size, &offset, &record))
+    {
+        if (record.type == LOG_BINARY_RECORD_FORMAT)
+        {
+            // Ids come from the file, so only ones a writer could have handed out size the table:
+            if (record.id != 0 && record.id < LOG_BINARY_MAX_FORMATS)
+            {
+                max_id = record.id > max_id ? record.id : max_id;
+            }
+        }
+        else
+        {
+            message_count++;
+        }
+    }
+    uint64_t end = offset;
+    if (end != size)
+    {
+        FWARN("log_binary_decode - Ignoring %llu bytes of truncated or corrupt data at the end.", size - end);
+    }
+
+    // Second pass: formats, and message timestamps for sorting.
+    arena format_arena;
+    arena_create(0, MEMORY_TAG_STRING, &format_arena);
+    uint64_t formats_size = sizeof(log_decoded_format) * ((uint64_t)max_id + 1);
+    log_decoded_format* formats = fallocate(formats_size, MEMORY_TAG_ARRAY);
+    fzero_memory(formats, formats_size);
+    uint64_t messages_size = sizeof(log_decoded_message) * (message_count ? message_count : 1);
+    log_decoded_message* messages = fallocate(messages_size, MEMORY_TAG_ARRAY);
+    log_decoded_message* scratch = fallocate(messages_size, MEMORY_TAG_ARRAY);
+
+    uint64_t message_index = 0;
+    offset = 8;
+    while (offset < end)
+    {
+        uint64_t record_offset = offset;
+        log_binary_next_record(data, size, &offset, &record);
+        if (record.type == LOG_BINARY_RECORD_FORMAT)
+        {
+            if (record.id == 0 || record.id > max_id)
+            {
+                FWARN("log_binary_decode - Skipping a format with invalid id %u.", record.id);
+                continue;
+            }
+            char* format = arena_allocate(&format_arena, record.payload_size + 1);
+            platform_copy_memory(format, record.payload, record.payload_size);
+            format[record.payload_size] = 0;
+            formats[record.id].format = format;
+            formats[record.id].level = record.level <= LOG_LEVEL_TRACE ? record.level : LOG_LEVEL_TRACE;
+        }
+        else
+        {
+            messages[message_index].timestamp = record.timestamp;
+            messages[message_index].offset = record_offset;
+            message_index++;
+        }
+    }
+
+    log_decoded_messages_sort(messages, scratch, message_count);
+
+    for (uint64_t i = 0; i < message_count; ++i)
+    {
+        offset = messages[i].offset;
+        log_binary_next_record(data, size, &offset, &record);
+
+        string_builder_append_f64(out_text, record.timestamp, 6);
+        string_builder_append(out_text, " [thread ");
+        string_builder_append_u64(out_text, record.thread_id);
+        string_builder_append(out_text, "] ");
+
+        const log_decoded_format* format = record.id <= max_id ? &formats[record.id] : 0;
+        if (format && format->format)
+        {
+            string_builder_append(out_text, level_strings[format->level]);
+            log_binary_format_message(out_text, format->format, record.payload, record.payload_size);
+        }
+        else
+        {
+            string_builder_append_format(out_text, "<unknown format id %u>", record.id);
+        }
+        string_builder_append_char(out_text, '\n');
+    }
+
+    ffree(scratch, messages_size, MEMORY_TAG_ARRAY);
+    ffree(messages, messages_size, MEMORY_TAG_ARRAY);
+    ffree(formats, formats_size, MEMORY_TAG_ARRAY);
+    arena_destroy(&format_arena);
+    return TRUE;
 }
 
 void report_assertion_failure(const char* expression, const char* message, const char* file, int32_t line)
@@ -2,15 +2,37 @@
 
 #include "defines.h"
 
+// Output modes for the LOG_*_ENABLED switches below:
+#define LOG_MODE_OFF (0)
+#define LOG_MODE_TEXT (1)
+// Records only a format id, timestamp, thread id and the raw arguments; decode with foo_log_decode.
+#define LOG_MODE_BINARY (2)
+
+// Compile-time switches. Each may be overridden by the build, e.g. -DLOG_TRACE_ENABLED=1 for a release build
+// whose traces can be switched on at runtime per category.
+#ifndef LOG_WARN_ENABLED
 #define LOG_WARN_ENABLED (1)
-#define LOG_INFO_ENABLED (1)
-#define LOG_DEBUG_ENABLED (1)
-#define LOG_TRACE_ENABLED (1)
+#endif
+
+#ifndef LOG_INFO_ENABLED
+#define LOG_INFO_ENABLED (LOG_MODE_TEXT)
+#endif
+
+// Debug and trace logging are compiled out of release builds:
+#ifndef LOG_DEBUG_ENABLED
+#if FRELEASE == 1
+#define LOG_DEBUG_ENABLED (LOG_MODE_OFF)
+#else
+#define LOG_DEBUG_ENABLED (LOG_MODE_TEXT)
+#endif
+#endif
 
-// Disable debug and trace logging for release builds:
+#ifndef LOG_TRACE_ENABLED
 #if FRELEASE == 1
-#define LOG_DEBUG_ENABLED 0
-#define LOG_TRACE_ENABLED 0
+#define LOG_TRACE_ENABLED (LOG_MODE_OFF)
+#else
+#define LOG_TRACE_ENABLED (LOG_MODE_TEXT)
+#endif
 #endif
 
 typedef enum log_level {
@@ -22,45 +44,161 @@ typedef enum log_level {
     LOG_LEVEL_TRACE = 5
 } log_level;
 
+typedef enum log_category
+{
+    LOG_CATEGORY_CORE,
+    LOG_CATEGORY_RENDERER,
+    LOG_CATEGORY_VULKAN,
+    LOG_CATEGORY_INPUT,
+    LOG_CATEGORY_MEMORY,
+    LOG_CATEGORY_GAME,
+    LOG_CATEGORY_MAX
+} log_category;
+
+// The category the logging macros in a source file use. Define it at the top of the file, before any include:
+#ifndef LOG_CATEGORY
+#define LOG_CATEGORY LOG_CATEGORY_CORE
+#endif
+
+// Runtime level per category, read directly by the logging macros so that a filtered-out message costs one
+// load and compare, before its arguments are evaluated. Change it with log_set_category_level.
+FAPI extern uint8_t log_category_levels[LOG_CATEGORY_MAX];
+
+// Defaults to LOG_LEVEL_TRACE, or LOG_LEVEL_INFO in release builds. Fatal messages are never filtered.
+FAPI void log_set_category_level(log_category category, log_level level);
+FAPI log_level log_get_category_level(log_category category);
+
+// Sets the level of every category:
+FAPI void log_set_level(log_level level);
+
+/**
+ * Limits each call site (identified by its format string address) to burst messages per window. Messages over
+ * the limit are skipped before formatting, and a message identical to the previous one from the same call site
+ * is collapsed; both are reported as counts once per window. Fatal messages are never limited.
+ * @param burst Messages allowed per window per call site; 0 disables limiting and collapsing. Default 30.
+ * @param window_seconds Length of the window. Default 1 second.
+ */
+FAPI void log_set_rate_limit(uint32_t burst, float64_t window_seconds);
+
+#define LOG_CATEGORY_ENABLED(level) ((level) <= log_category_levels[LOG_CATEGORY])
+
+typedef enum log_file_sync
+{
+    // Leave write-back to the OS:
+    LOG_FILE_SYNC_NONE,
+    // fdatasync/FlushFileBuffers after every buffer written, so the log survives a machine crash:
+    LOG_FILE_SYNC_DATA
+} log_file_sync;
+
+typedef struct log_file_config
+{
+    // 0 disables the file sink. Rotated files get .1, .2, ... appended; .1 is the most recent.
+    const char* path;
+    // Rotate once the file reaches this size. 0 to disable:
+    uint64_t max_size;
+    // Rotate once the file has been open this long. 0 to disable:
+    uint32_t max_age_seconds;
+    // Number of rotated files kept:
+    uint32_t rotation_count;
+    // Buffered output is written at least this often. Errors are written immediately.
+    uint32_t flush_interval_ms;
+    log_file_sync sync;
+} log_file_config;
+
+/**
+ * Configures the log file sink. Takes effect at the next initialize_logging, so call it before
+ * application_create. Defaults: "console.log", 64 MiB, no age limit, 5 rotations, 1000 ms, LOG_FILE_SYNC_NONE.
+ */
+FAPI void log_file_configure(const log_file_config* config);
+
 bool8_t initialize_logging();
 void shutdown_logging();
 
+/**
+ * Formats and writes a log message. Use the FERROR/FWARN/... macros rather than calling this directly.
+ * N.B: The message must be a string literal. The rate limiter keys call sites on its address and the log writer
+ * reads it again later, so text from elsewhere (e.g. a driver's message) goes in as an argument: FERROR("%s", text).
+ * The macros reject anything but a literal at compile time.
+ */
 FAPI void log_output(log_level level, const char* message, ...);
 
+struct string_builder;
+
+/**
+ * Binary (deferred-format) logging. The format string is registered once per call site and written to the
+ * binary log a single time; every call after that appends a small record with the format id, timestamp,
+ * thread id and the argument bytes to a per-thread buffer. Formatting happens offline in log_binary_decode.
+ * Formats using conversions that can't be recorded (%n, long double) fall back to text output.
+ * @param format_id Per-call-site id storage, 0 until registered. Provided by the FLOG_BINARY macro.
+ */
+FAPI void log_binary_output(uint32_t* format_id, log_level level, const char* format, ...);
+
+// Hands the calling thread's binary records to the log writer. Threads other than the main thread should call
+// this before exiting; the main thread's buffer is flushed by shutdown_logging.
+FAPI void log_binary_flush_thread();
+
+// Decodes the contents of a binary log file to text, one line per record in timestamp order.
+FAPI bool8_t log_binary_decode(const uint8_t* data, uint64_t size, struct string_builder* out_text);
+
+#define FLOG_BINARY(level, message, ...)                                                                \
+    do                                                                                                  \
+    {                                                                                                   \
+        static uint32_t log_format_id = 0;                                                              \
+        if (LOG_CATEGORY_ENABLED(level))                                                                \
+        {                                                                                               \
+            log_binary_output(&log_format_id, level, "" message __VA_OPT__(,) __VA_ARGS__);             \
+        }                                                                                               \
+    } while (0)
+
+#define FLOG_TEXT(level, message, ...)                                                                  \
+    do                                                                                                  \
+    {                                                                                                   \
+        if (LOG_CATEGORY_ENABLED(level))                                                                \
+        {                                                                                               \
+            log_output(level, "" message __VA_OPT__(,) __VA_ARGS__);                                    \
+        }                                                                                               \
+    } while (0)
+
 #ifndef FFATAL
 // Logs fatal-level messages:
-#define FFATAL(message, ...) log_output(LOG_LEVEL_FATAL, message __VA_OPT__(,) __VA_ARGS__)
+#define FFATAL(message, ...) log_output(LOG_LEVEL_FATAL, "" message __VA_OPT__(,) __VA_ARGS__)
 #endif
 
 #ifndef FERROR
 // Logs error-level messages:
-#define FERROR(message, ...) log_output(LOG_LEVEL_ERROR, message __VA_OPT__(,) __VA_ARGS__)
+#define FERROR(message, ...) FLOG_TEXT(LOG_LEVEL_ERROR, message __VA_OPT__(,) __VA_ARGS__)
 #endif
 
 #if LOG_WARN_ENABLED == 1
 // Logs warning-level messages:
-#define FWARN(message, ...) log_output(LOG_LEVEL_WARN, message __VA_OPT__(,) __VA_ARGS__)
+#define FWARN(message, ...) FLOG_TEXT(LOG_LEVEL_WARN, message __VA_OPT__(,) __VA_ARGS__)
 #else
 #define FWARN(message, ...)
 #endif
 
-#if LOG_INFO_ENABLED == 1
+#if LOG_INFO_ENABLED == LOG_MODE_BINARY
 // Logs info-level messages:
-#define FINFO(message, ...) log_output(LOG_LEVEL_INFO, message __VA_OPT__(,) __VA_ARGS__)
+#define FINFO(message, ...) FLOG_BINARY(LOG_LEVEL_INFO, message __VA_OPT__(,) __VA_ARGS__)
+#elif LOG_INFO_ENABLED == LOG_MODE_TEXT
+#define FINFO(message, ...) FLOG_TEXT(LOG_LEVEL_INFO, message __VA_OPT__(,) __VA_ARGS__)
 #else
 #define FINFO(message, ...)
 #endif
 
-#if LOG_DEBUG_ENABLED == 1
+#if LOG_DEBUG_ENABLED == LOG_MODE_BINARY
 // Logs debug-level messages:
-#define FDEBUG(message, ...) log_output(LOG_LEVEL_DEBUG, message __VA_OPT__(,) __VA_ARGS__)
+#define FDEBUG(message, ...) FLOG_BINARY(LOG_LEVEL_DEBUG, message __VA_OPT__(,) __VA_ARGS__)
+#elif LOG_DEBUG_ENABLED == LOG_MODE_TEXT
+#define FDEBUG(message, ...) FLOG_TEXT(LOG_LEVEL_DEBUG, message __VA_OPT__(,) __VA_ARGS__)
 #else
 #define FDEBUG(message, ...)
 #endif
 
-#if LOG_TRACE_ENABLED == 1
+#if LOG_TRACE_ENABLED == LOG_MODE_BINARY
 // Logs trace-level messages:
-#define FTRACE(message, ...) log_output(LOG_LEVEL_TRACE, message __VA_OPT__(,) __VA_ARGS__)
+#define FTRACE(message, ...) FLOG_BINARY(LOG_LEVEL_TRACE, message __VA_OPT__(,) __VA_ARGS__)
+#elif LOG_TRACE_ENABLED == LOG_MODE_TEXT
+#define FTRACE(message, ...) FLOG_TEXT(LOG_LEVEL_TRACE, message __VA_OPT__(,) __VA_ARGS__)
 #else
 #define FTRACE(message, ...)
 #endif
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "core/metrics.h"
+
+#include "core/fmemory.h"
+
+void sample_window_create(uint32_t capacity, sample_window* out_window)
+{
+    out_window->samples = fallocate(sizeof(float64_t) * capacity, MEMORY_TAG_ARRAY);
+    // Room for the copy being sorted plus the merge sort's second buffer:
+    out_window->sorted = fallocate(sizeof(float64_t) * capacity * 2, MEMORY_TAG_ARRAY);
+    out_window->capacity = capacity;
+    out_window->count = 0;
+    out_window->next = 0;
+}
+
+void sample_window_destroy(sample_window* window)
+{
+    if (window->samples)
+    {
+        ffree(window->samples, sizeof(float64_t) * window->capacity, MEMORY_TAG_ARRAY);
+        ffree(window->sorted, sizeof(float64_t) * window->capacity * 2, MEMORY_TAG_ARRAY);
+    }
+    window->samples = 0;
+    window->sorted = 0;
+    window->capacity = 0;
+    window->count = 0;
+    window->next = 0;
+}
+
+void sample_window_add(sample_window* window, float64_t sample)
+{
+    window->samples[window->next] = sample;
+    window->next = window->next + 1 == window->capacity ? 0 : window->next + 1;
+    if (window->count < window->capacity)
+    {
+        window->count++;
+    }
+}
+
+void sample_window_clear(sample_window* window)
+{
+    window->count = 0;
+    window->next = 0;
+}
+
+// Bottom-up merge sort between the two buffers. Returns whichever one ends up holding the sorted samples:
+static float64_t* sample_sort(float64_t* values, float64_t* scratch, uint32_t count)
+{
+    for (uint32_t width = 1; width < count; width *= 2)
+    {
+        for (uint32_t start = 0; start < count; start += 2 * width)
+        {
+            uint32_t middle = start + width < count ? start + width : count;
+            uint32_t end = start + 2 * width < count ? start + 2 * width : count;
+            uint32_t left = start;
+            uint32_t right = middle;
+            for (uint32_t out = start; out < end; ++out)
+            {
+                scratch[out] = (left < middle && (right >= end || values[left] <= values[right])) ?
+                    values[left++] : values[right++];
+            }
+        }
+
+        float64_t* swap = values;
+        values = scratch;
+        scratch = swap;
+    }
+    return values;
+}
+
+// Nearest-rank percentile of sorted samples:
+static float64_t sample_percentile(const float64_t* sorted, uint32_t count, float64_t percentile)
+{
+    uint32_t rank = (uint32_t)(percentile / 100.0 * count + 0.999999);
+    rank = rank == 0 ? 1 : rank > count ? count : rank;
+    return sorted[rank - 1];
+}
+
+void sample_window_summarize(sample_window* window, sample_summary* out_summary)
+{
+    fzero_memory(out_summary, sizeof(sample_summary));
+    uint32_t count = window->count;
+    if (count == 0)
+    {
+        return;
+    }
+
+    float64_t sum = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        window->sorted[i] = window->samples[i];
+        sum += window->samples[i];
+    }
+    float64_t* sorted = sample_sort(window->sorted, window->sorted + window->capacity, count);
+
+    out_summary->count = count;
+    out_summary->min = sorted[0];
+    out_summary->max = sorted[count - 1];
+    out_summary->mean = sum / count;
+    out_summary->p50 = sample_percentile(sorted, count, 50.0);
+    out_summary->p90 = sample_percentile(sorted, count, 90.0);
+    out_summary->p95 = sample_percentile(sorted, count, 95.0);
+    out_summary->p99 = sample_percentile(sorted, count, 99.0);
+}
+
+void sample_histogram_create(float64_t min_value, uint32_t sub_bucket_bits, uint32_t octaves,
+    sample_histogram* out_histogram)
+{
+    out_histogram->min_value = min_value;
+    out_histogram->sub_bucket_bits = sub_bucket_bits;
+    out_histogram->octaves = octaves;
+    out_histogram->bucket_count = octaves << sub_bucket_bits;
+    out_histogram->counts = fallocate(sizeof(uint64_t) * out_histogram->bucket_count, MEMORY_TAG_ARRAY);
+    out_histogram->total = 0;
+}
+
+void sample_histogram_destroy(sample_histogram* histogram)
+{
+    if (histogram->counts)
+    {
+        ffree(histogram->counts, sizeof(uint64_t) * histogram->bucket_count, MEMORY_TAG_ARRAY);
+    }
+    fzero_memory(histogram, sizeof(sample_histogram));
+}
+
+void sample_histogram_add(sample_histogram* histogram, float64_t sample)
+{
+    uint32_t bucket = 0;
+    float64_t ratio = sample / histogram->min_value;
+    if (ratio >= 1.0)
+    {
+        // The exponent picks the octave, the top mantissa bits the bucket within it:
+        union
+        {
+            float64_t f;
+            uint64_t u;
+        } bits = {ratio};
+        uint32_t octave = (uint32_t)((bits.u >> 52) & 0x7FF) - 1023;
+        if (octave >= histogram->octaves)
+        {
+            bucket = histogram->bucket_count - 1;
+        }
+        else
+        {
+            uint64_t sub_bucket = (bits.u & 0xFFFFFFFFFFFFFull) >> (52 - histogram->sub_bucket_bits);
+            bucket = (octave << histogram->sub_bucket_bits) | (uint32_t)sub_bucket;
+        }
+    }
+
+    histogram->counts[bucket]++;
+    histogram->total++;
+}
+
+void sample_histogram_clear(sample_histogram* histogram)
+{
+    fzero_memory(histogram->counts, sizeof(uint64_t) * histogram->bucket_count);
+    histogram->total = 0;
+}
+
+void sample_histogram_bucket_bounds(const sample_histogram* histogram, uint32_t bucket, float64_t* out_lower,
+    float64_t* out_upper)
+{
+    uint32_t octave = bucket >> histogram->sub_bucket_bits;
+    uint32_t sub_bucket = bucket & ((1u << histogram->sub_bucket_bits) - 1);
+    float64_t octave_start = histogram->min_value * (float64_t)(1ull << octave);
+    float64_t width = octave_start / (float64_t)(1u << histogram->sub_bucket_bits);
+    *out_lower = octave_start + width * sub_bucket;
+    *out_upper = *out_lower + width;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ * Fixed-size window over the most recent samples of a measurement (frame times, latencies, ...), summarized into
+ * percentiles on demand. Adding a sample is O(1); summarizing sorts a copy of the window.
+ */
+
+typedef struct sample_window
+{
+    float64_t* samples;
+    // Scratch space for summarizing (2 * capacity), so it does not allocate:
+    float64_t* sorted;
+    uint32_t capacity;
+    uint32_t count;
+    // Where the next sample goes once the window is full:
+    uint32_t next;
+} sample_window;
+
+typedef struct sample_summary
+{
+    uint32_t count;
+    float64_t min;
+    float64_t max;
+    float64_t mean;
+    float64_t p50;
+    float64_t p90;
+    float64_t p95;
+    float64_t p99;
+} sample_summary;
+
+FAPI void sample_window_create(uint32_t capacity, sample_window* out_window);
+FAPI void sample_window_destroy(sample_window* window);
+
+// Adds a sample, replacing the oldest one once the window is full:
+FAPI void sample_window_add(sample_window* window, float64_t sample);
+FAPI void sample_window_clear(sample_window* window);
+
+// Summarizes the samples currently in the window. All fields are 0 if it is empty.
+FAPI void sample_window_summarize(sample_window* window, sample_summary* out_summary);
+
+/*
+ * Log-linear histogram: each power-of-two range (octave) above min_value is split into 1 << sub_bucket_bits equal
+ * buckets, so the relative resolution is the same at every magnitude. Bucketing reads the exponent and top mantissa
+ * bits of the value, so adding a sample is a handful of integer operations. Unlike a sample_window it never forgets;
+ * it counts every sample since it was created or cleared.
+ */
+typedef struct sample_histogram
+{
+    uint64_t* counts;
+    // Lower bound of the first bucket. Smaller samples are counted in the first bucket:
+    float64_t min_value;
+    uint32_t sub_bucket_bits;
+    // Samples beyond the last octave are counted in the last bucket:
+    uint32_t octaves;
+    uint32_t bucket_count;
+    uint64_t total;
+} sample_histogram;
+
+/**
+ * Creates a histogram covering min_value to min_value * 2^octaves.
+ * @param min_value The lower bound of the first bucket. Must be greater than 0.
+ * @param sub_bucket_bits Each octave is split into 1 << sub_bucket_bits buckets, e.g. 4 for ~4.4% resolution.
+ * @param octaves The amount of power-of-two ranges covered.
+ * @param out_histogram The histogram to initialize.
+ */
+FAPI void sample_histogram_create(float64_t min_value, uint32_t sub_bucket_bits, uint32_t octaves,
+    sample_histogram* out_histogram);
+FAPI void sample_histogram_destroy(sample_histogram* histogram);
+
+FAPI void sample_histogram_add(sample_histogram* histogram, float64_t sample);
+FAPI void sample_histogram_clear(sample_histogram* histogram);
+
+// Gets the range [out_lower, out_upper) of samples counted in a bucket:
+FAPI void sample_histogram_bucket_bounds(const sample_histogram* histogram, uint32_t bucket, float64_t* out_lower,
+    float64_t* out_upper);
@@ -0,0 +1,307 @@
+#include "core/profiler.h"
+
+#include "core/fmemory.h"
+#include "core/fstring.h"
+#include "core/logger.h"
+#include "platform/platform.h"
+
+#include <stdatomic.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define PROFILER_RECORD_MASK (PROFILER_THREAD_CAPACITY - 1)
+// Records right behind the write position of a thread that keeps recording during an export may be overwritten
+// while they are read, so that much of a full ring is skipped:
+#define PROFILER_EXPORT_MARGIN (PROFILER_THREAD_CAPACITY / 8)
+// How much of the trace is buffered before it is written out:
+#define PROFILER_EXPORT_CHUNK (256 * 1024)
+// Shortest time to measure the timestamp rate over:
+#define PROFILER_MIN_CALIBRATION 0.01
+
+// A zone begin, or a zone end if location is 0:
+typedef struct profile_record
+{
+    uint64_t timestamp;
+    const profile_location* location;
+} profile_record;
+
+typedef struct profile_thread
+{
+    struct profile_thread* next;
+    const char* name;
+    uint32_t id;
+    // Only written by the owning thread; read by the exporter:
+    _Atomic(uint64_t) write_index;
+    profile_record records[PROFILER_THREAD_CAPACITY];
+} profile_thread;
+
+typedef struct profiler_state
+{
+    // Every thread that ever recorded a zone, newest first. Buffers live until shutdown:
+    _Atomic(profile_thread*) threads;
+    _Atomic(uint32_t) next_thread_id;
+
+    // Timestamp and absolute time at initialization, to convert timestamps to time:
+    uint64_t base_timestamp;
+    float64_t base_time;
+} profiler_state;
+
+static bool8_t initialized = FALSE;
+static profiler_state state;
+
+static _Thread_local profile_thread* thread_buffer;
+
+// The CPU's timestamp counter. Invariant TSCs run at a fixed rate on every core, so it is converted to time with a
+// rate measured between initialization and export:
+static inline uint64_t profiler_timestamp()
+{
+#if defined(_MSC_VER)
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (uint64_t)(platform_get_absolute_time() * 1000000000.0);
+#endif
+}
+
+bool8_t profiler_initialize()
+{
+    if (initialized)
+    {
+        FERROR("profiler_initialize called more than once.");
+        return FALSE;
+    }
+
+    state.base_time = platform_get_absolute_time();
+    state.base_timestamp = profiler_timestamp();
+    initialized = TRUE;
+    return TRUE;
+}
+
+void profiler_shutdown()
+{
+    profile_thread* thread = atomic_exchange(&state.threads, 0);
+    while (thread)
+    {
+        profile_thread* next = thread->next;
+        platform_free(thread, FALSE);
+        thread = next;
+    }
+    // Other threads are expected to be done by now; the calling thread may start a new buffer:
+    thread_buffer = 0;
+
+    initialized = FALSE;
+}
+
+// Creates the calling thread's buffer on its first zone:
+static profile_thread* profiler_thread_create()
+{
+    // N.B: Not through fallocate, its usage counters are only safe to touch from the main thread:
+    profile_thread* thread = platform_allocate(sizeof(profile_thread), FALSE);
+    thread->name = 0;
+    thread->id = atomic_fetch_add_explicit(&state.next_thread_id, 1, memory_order_relaxed);
+    atomic_init(&thread->write_index, 0);
+
+    profile_thread* head = atomic_load_explicit(&state.threads, memory_order_relaxed);
+    do
+    {
+        thread->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&state.threads, &head, thread, memory_order_release,
+        memory_order_relaxed));
+
+    thread_buffer = thread;
+    return thread;
+}
+
+static inline void profiler_record(const profile_location* location)
+{
+    profile_thread* thread = thread_buffer;
+    if (!thread)
+    {
+        thread = profiler_thread_create();
+    }
+
+    uint64_t index = atomic_load_explicit(&thread->write_index, memory_order_relaxed);
+    profile_record* record = &thread->records[index & PROFILER_RECORD_MASK];
+    record->timestamp = profiler_timestamp();
+    record->location = location;
+    atomic_store_explicit(&thread->write_index, index + 1, memory_order_release);
+}
+
+void profiler_zone_begin(const profile_location* location)
+{
+#if PROFILER_ENABLED
+    profiler_record(location);
+#endif
+}
+
+void profiler_zone_end()
+{
+#if PROFILER_ENABLED
+    profiler_record(0);
+#endif
+}
+
+void profiler_set_thread_name(const char* name)
+{
+#if PROFILER_ENABLED
+    profile_thread* thread = thread_buffer;
+    if (!thread)
+    {
+        thread = profiler_thread_create();
+    }
+    thread->name = name;
+#endif
+}
+
+#if PROFILER_ENABLED
+static void profiler_append_json_string(string_builder* builder, const char* str)
+{
+    string_builder_append_char(builder, '"');
+    for (const char* c = str; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            string_builder_append_char(builder, '\\');
+            string_builder_append_char(builder, *c);
+        }
+        else if ((uint8_t)*c < 0x20)
+        {
+            string_builder_append_format(builder, "\\u%04x", (uint32_t)(uint8_t)*c);
+        }
+        else
+        {
+            string_builder_append_char(builder, *c);
+        }
+    }
+    string_builder_append_char(builder, '"');
+}
+
+// Writes out what is buffered once it exceeds PROFILER_EXPORT_CHUNK, or always if forced:
+static bool8_t profiler_flush(string_builder* builder, platform_file* file, bool8_t force)
+{
+    if (builder->length < PROFILER_EXPORT_CHUNK && !force)
+    {
+        return TRUE;
+    }
+
+    bool8_t result = platform_file_write(file, builder->buffer, builder->length);
+    string_builder_clear(builder);
+    return result;
+}
+
+static bool8_t profiler_export_thread(profile_thread* thread, float64_t ticks_per_microsecond,
+    string_builder* builder, platform_file* file)
+{
+    const char* name = thread->name ? thread->name : "thread";
+    string_builder_append_format(builder,
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", thread->id);
+    profiler_append_json_string(builder, name);
+    string_builder_append(builder, "}},\n");
+
+    uint64_t end = atomic_load_explicit(&thread->write_index, memory_order_acquire);
+    uint64_t start = end > PROFILER_THREAD_CAPACITY ? end - PROFILER_THREAD_CAPACITY + PROFILER_EXPORT_MARGIN : 0;
+
+    // Ends whose begin fell out of the ring are dropped, and zones still open are closed at the last timestamp:
+    uint32_t depth = 0;
+    float64_t last_time = 0;
+    for (uint64_t i = start; i < end; ++i)
+    {
+        const profile_record* record = &thread->records[i & PROFILER_RECORD_MASK];
+        last_time = (float64_t)(int64_t)(record->timestamp - state.base_timestamp) / ticks_per_microsecond;
+        if (record->location)
+        {
+            const profile_location* location = record->location;
+            string_builder_append(builder, "{\"name\":");
+            profiler_append_json_string(builder, location->name);
+            string_builder_append_format(builder, ",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"file\":",
+                last_time, thread->id);
+            profiler_append_json_string(builder, location->file);
+            string_builder_append_format(builder, ",\"line\":%u}},\n", location->line);
+            depth++;
+        }
+        else if (depth > 0)
+        {
+            string_builder_append_format(builder, "{\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%u},\n", last_time,
+                thread->id);
+            depth--;
+        }
+
+        if (!profiler_flush(builder, file, FALSE))
+        {
+            return FALSE;
+        }
+    }
+
+    for (; depth > 0; --depth)
+    {
+        string_builder_append_format(builder, "{\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%u},\n", last_time,
+            thread->id);
+    }
+    return TRUE;
+}
+#endif
+
+bool8_t profiler_export_chrome_trace(const char* path)
+{
+#if PROFILER_ENABLED
+    if (!initialized)
+    {
+        FERROR("profiler_export_chrome_trace called before the profiler was initialized.");
+        return FALSE;
+    }
+
+    // Measure the timestamp rate over everything since initialization:
+    float64_t elapsed = platform_get_absolute_time() - state.base_time;
+    while (elapsed < PROFILER_MIN_CALIBRATION)
+    {
+        platform_cpu_relax();
+        elapsed = platform_get_absolute_time() - state.base_time;
+    }
+    float64_t ticks_per_microsecond = (float64_t)(profiler_timestamp() - state.base_timestamp) / (elapsed * 1000000.0);
+
+    platform_file file;
+    if (!platform_file_open(path, FALSE, &file))
+    {
+        FERROR("Unable to open trace file '%s'.", path);
+        return FALSE;
+    }
+
+    string_builder builder;
+    string_builder_create(0, PROFILER_EXPORT_CHUNK + 4096, &builder);
+    string_builder_append(&builder, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool8_t result = TRUE;
+    uint32_t thread_count = 0;
+    for (profile_thread* thread = atomic_load_explicit(&state.threads, memory_order_acquire); thread && result;
+        thread = thread->next)
+    {
+        result = profiler_export_thread(thread, ticks_per_microsecond, &builder, &file);
+        thread_count++;
+    }
+
+    // A metadata record closes the list, so every record above can end with a comma:
+    string_builder_append(&builder,
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"foo\"}}\n]}\n");
+    result = result && profiler_flush(&builder, &file, TRUE);
+    string_builder_destroy(&builder);
+    platform_file_close(&file);
+
+    if (!result)
+    {
+        FERROR("Failed to write trace file '%s'.", path);
+        return FALSE;
+    }
+    FINFO("Wrote profile of %u thread(s) to '%s'.", thread_count, path);
+    return TRUE;
+#else
+    FERROR("profiler_export_chrome_trace: the profiler is compiled out of this build.");
+    return FALSE;
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "defines.h"
+
+/*
+ * Scoped CPU profiler.
+ *
+ * PROFILE_ZONE_BEGIN/PROFILE_ZONE_END bracket a zone. Each expands to a call that stores a CPU timestamp and a pointer
+ * to a static source location record into the calling thread's ring buffer, so a zone costs two stores and two
+ * timestamp reads. Zones nest, must be ended on the thread that began them, and must be ended before every return
+ * in between. The rings keep the most recent PROFILER_THREAD_CAPACITY records of every thread and are exported as
+ * Chrome trace JSON, which loads in chrome://tracing or the Perfetto UI (ui.perfetto.dev, "Open trace file").
+ *
+ * Compiled out of release builds unless the build overrides PROFILER_ENABLED; the macros then expand to nothing and
+ * the functions below record nothing.
+ */
+#ifndef PROFILER_ENABLED
+#if FRELEASE == 1
+#define PROFILER_ENABLED 0
+#else
+#define PROFILER_ENABLED 1
+#endif
+#endif
+
+// Records per thread, 16 bytes each:
+#define PROFILER_THREAD_CAPACITY (1 << 16)
+
+// Where a zone is in the source. One static instance per PROFILE_ZONE_BEGIN:
+typedef struct profile_location
+{
+    const char* name;
+    const char* file;
+    const char* function;
+    uint32_t line;
+} profile_location;
+
+#if PROFILER_ENABLED
+#define PROFILE_ZONE_BEGIN(zone_name)                                                                           \
+    do                                                                                                          \
+    {                                                                                                           \
+        static const profile_location profile_zone_location = {zone_name, __FILE__, __func__, __LINE__};        \
+        profiler_zone_begin(&profile_zone_location);                                                            \
+    } while (0)
+#define PROFILE_ZONE_END() profiler_zone_end()
+#else
+#define PROFILE_ZONE_BEGIN(zone_name) \
+    do                                \
+    {                                 \
+    } while (0)
+#define PROFILE_ZONE_END() \
+    do                     \
+    {                      \
+    } while (0)
+#endif
+
+// Zone named after the enclosing function:
+#define PROFILE_FUNCTION_BEGIN() PROFILE_ZONE_BEGIN(__func__)
+
+bool8_t profiler_initialize();
+void profiler_shutdown();
+
+// Use the PROFILE_ZONE_* macros rather than calling these directly:
+FAPI void profiler_zone_begin(const profile_location* location);
+FAPI void profiler_zone_end();
+
+// Names the calling thread in exported traces. The name must outlive the profiler, e.g. a string literal.
+FAPI void profiler_set_thread_name(const char* name);
+
+/**
+ * Writes the recorded zones of every thread to path as Chrome trace JSON. Main thread only; other threads may keep
+ * recording, but their newest zones may then be missing from the trace.
+ * @returns TRUE if the file was written; otherwise FALSE, also when the profiler is compiled out.
+ */
+FAPI bool8_t profiler_export_chrome_trace(const char* path);
@@ -14,11 +14,12 @@ typedef struct game
     // Function ptr to game's initialize function:
     bool8_t (*initialize)(struct game* game_instance);
 
-    // Function ptr to game's update function:
+    // Function ptr to game's update function. With a fixed tick rate, delta_time is always 1 / tick_rate:
     bool8_t (*update)(struct game* game_instance, float32_t delta_time);
 
-    // Function ptr to game's render function:
-    bool8_t (*render)(struct game* game_instance, float32_t delta_time);
+    // Function ptr to game's render function. alpha is how far (0-1) the simulation clock is between the last tick
+    // and the next one, for interpolating between the two states; it is always 1 without a fixed tick rate:
+    bool8_t (*render)(struct game* game_instance, float32_t delta_time, float32_t alpha);
 
     // Function ptr to handle resizes, if applicable:
     void (*on_resize)(struct game* game_instance, uint32_t width, uint32_t height);
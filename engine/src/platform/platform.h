@@ -23,9 +23,79 @@ void* platform_set_memory(void* dest, int32_t value, uint64_t size);
 void platform_console_write(const char* message, uint8_t color);
 void platform_console_write_error(const char* message, uint8_t color);
 
-float64_t platform_get_absolute_time();
+FAPI float64_t platform_get_absolute_time();
 
 // Sleep on the thread for the provided ms. This blocks the main thread.auto
 // Should only be used for giving time back to the OS for unused update power.
 // Therefore, it is not exported.
-void platform_sleep(uint64_t ms);
\ No newline at end of file
+void platform_sleep(uint64_t ms);
+
+/**
+ * Sleeps the calling thread until the given time, with the finest granularity the OS offers. The OS may still wake
+ * the thread late by its scheduling latency; callers needing tighter deadlines sleep until slightly before and spin.
+ * @param time The time to wake at, on the platform_get_absolute_time clock.
+ */
+void platform_sleep_until(float64_t time);
+
+// Hints to the CPU that the caller is busy-waiting, e.g. the x86 pause instruction:
+void platform_cpu_relax();
+// -- Threads --
+
+typedef struct platform_thread
+{
+    void* internal_data;
+} platform_thread;
+
+typedef uint32_t (*pfn_platform_thread_start)(void* params);
+
+// Starts a thread running start(params). Returns FALSE if the thread could not be created.
+bool8_t platform_thread_create(pfn_platform_thread_start start, void* params, platform_thread* out_thread);
+
+// Blocks until the thread has exited and releases it.
+void platform_thread_join(platform_thread* thread);
+
+// -- Semaphores --
+
+typedef struct platform_semaphore
+{
+    void* internal_data;
+} platform_semaphore;
+
+bool8_t platform_semaphore_create(uint32_t initial_count, platform_semaphore* out_semaphore);
+void platform_semaphore_destroy(platform_semaphore* semaphore);
+void platform_semaphore_signal(platform_semaphore* semaphore);
+
+// Waits until the semaphore is signaled or timeout_ms elapses. Returns TRUE if it was signaled.
+bool8_t platform_semaphore_wait(platform_semaphore* semaphore, uint64_t timeout_ms);
+
+// -- Files --
+
+typedef struct platform_file
+{
+    void* handle;
+    bool8_t is_valid;
+} platform_file;
+
+// Opens a file for writing, creating it if needed. Existing contents are kept if append is TRUE.
+bool8_t platform_file_open(const char* path, bool8_t append, platform_file* out_file);
+
+// Opens an existing file for reading. Returns FALSE (without logging) if it does not exist or can't be opened.
+bool8_t platform_file_open_read(const char* path, platform_file* out_file);
+void platform_file_close(platform_file* file);
+
+bool8_t platform_file_size(platform_file* file, uint64_t* out_size);
+
+// Reads up to size bytes, stopping early only at the end of the file. Returns FALSE if the read failed.
+bool8_t platform_file_read(platform_file* file, void* buffer, uint64_t size, uint64_t* out_read);
+
+// Writes all size bytes. Returns FALSE if the write failed.
+bool8_t platform_file_write(platform_file* file, const void* data, uint64_t size);
+
+// Flushes written data (not necessarily metadata) to the storage device.
+bool8_t platform_file_sync(platform_file* file);
+
+// Renames a file, replacing new_path if it exists. Returns FALSE (without logging) if it failed.
+bool8_t platform_file_rename(const char* old_path, const char* new_path);
+
+// Returns the value of an environment variable, or 0 if it is not set. Valid until the environment changes.
+const char* platform_get_environment_variable(const char* name);
@@ -21,6 +21,12 @@
 #include <X11/Xlib.h>
 #include <X11/xlib-xcb.h> // sudo apt-get install libxkbcommon-x11-dev
 #include <sys/time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #if _POSIX_C_SOURCE >= 199309L
 #include <time.h> // nanosleep
@@ -47,6 +53,9 @@ typedef struct internal_state
     xcb_atom_t wm_protocols;
     xcb_atom_t wm_delete_win;
     VkSurfaceKHR surface;
+    // X server time (ms) to platform_get_absolute_time offset, see linux_event_time:
+    float64_t time_offset;
+    bool8_t has_time_offset;
 } internal_state;
 
 // Key translation:
@@ -58,6 +67,7 @@ bool8_t platform_startup(platform_state* plat_state, const char* application_nam
     // Create the internal state.
     plat_state->internal_state = malloc(sizeof(internal_state));
     internal_state* state = (internal_state*)plat_state->internal_state;
+    state->has_time_offset = FALSE;
 
     // Connect to X:
     state->display = XOpenDisplay(NULL);
@@ -158,6 +168,23 @@ void platform_shutdown(platform_state* plat_state)
     xcb_destroy_window(state->connection, state->window);
 }
 
+// Maps an X server timestamp onto the monotonic clock. The two clocks are related by a fixed offset plus the delivery
+// delay, so the smallest offset seen is the best estimate of the fixed part. The server time wraps every ~49.7 days,
+// which shows up as a large jump in the offset and re-seeds it:
+static float64_t linux_event_time(internal_state* state, xcb_timestamp_t time)
+{
+    float64_t now = platform_get_absolute_time();
+    float64_t offset = now - time * 0.001;
+    if (!state->has_time_offset || offset < state->time_offset || offset - state->time_offset > 1000.0)
+    {
+        state->time_offset = offset;
+        state->has_time_offset = TRUE;
+    }
+
+    float64_t event_time = time * 0.001 + state->time_offset;
+    return event_time < now ? event_time : now;
+}
+
 bool8_t platform_pump_messages(platform_state* plat_state)
 {
     internal_state* state = (internal_state*)plat_state->internal_state;
@@ -199,6 +226,7 @@ bool8_t platform_pump_messages(platform_state* plat_state)
                 keys key = translate_keycode(key_sym);
 
                 // Pass to the input subsystem for processing:
+                input_set_event_time(linux_event_time(state, kb_event->time));
                 input_process_key(key, pressed);
             }
             break;
@@ -223,12 +251,14 @@ bool8_t platform_pump_messages(platform_state* plat_state)
 
                 if (mouse_button != BUTTON_MAX_BUTTONS)
                 {
+                    input_set_event_time(linux_event_time(state, mouse_event->time));
                     input_process_mouse_button(mouse_button, pressed);
                 }
             }
             break;
             case XCB_MOTION_NOTIFY:
                 xcb_motion_notify_event_t* move_event = (xcb_motion_notify_event_t*)event;
+                input_set_event_time(linux_event_time(state, move_event->time));
                 input_process_mouse_move(move_event->event_x, move_event->event_y);
             break;
             case XCB_CONFIGURE_NOTIFY:
@@ -323,6 +353,241 @@ void platform_sleep(uint64_t ms)
 #endif
 }
 
+void platform_sleep_until(float64_t time)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)time;
+    ts.tv_nsec = (long)((time - (float64_t)ts.tv_sec) * 1000000000.0);
+    if (ts.tv_nsec >= 1000000000L)
+    {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    // Absolute, so resuming after a signal doesn't oversleep:
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR)
+    {
+    }
+}
+
+void platform_cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+typedef struct linux_thread
+{
+    pthread_t handle;
+    pfn_platform_thread_start start;
+    void* params;
+} linux_thread;
+
+static void* linux_thread_entry(void* params)
+{
+    linux_thread* thread = (linux_thread*)params;
+    thread->start(thread->params);
+    return 0;
+}
+
+bool8_t platform_thread_create(pfn_platform_thread_start start, void* params, platform_thread* out_thread)
+{
+    linux_thread* thread = malloc(sizeof(linux_thread));
+    thread->start = start;
+    thread->params = params;
+
+    if (0 != pthread_create(&thread->handle, 0, linux_thread_entry, thread))
+    {
+        FERROR("pthread_create failed.");
+        free(thread);
+        out_thread->internal_data = 0;
+        return FALSE;
+    }
+
+    out_thread->internal_data = thread;
+    return TRUE;
+}
+
+void platform_thread_join(platform_thread* thread)
+{
+    linux_thread* internal = (linux_thread*)thread->internal_data;
+    if (internal)
+    {
+        pthread_join(internal->handle, 0);
+        free(internal);
+        thread->internal_data = 0;
+    }
+}
+
+bool8_t platform_semaphore_create(uint32_t initial_count, platform_semaphore* out_semaphore)
+{
+    sem_t* semaphore = malloc(sizeof(sem_t));
+    if (0 != sem_init(semaphore, 0, initial_count))
+    {
+        FERROR("sem_init failed.");
+        free(semaphore);
+        out_semaphore->internal_data = 0;
+        return FALSE;
+    }
+
+    out_semaphore->internal_data = semaphore;
+    return TRUE;
+}
+
+void platform_semaphore_destroy(platform_semaphore* semaphore)
+{
+    if (semaphore->internal_data)
+    {
+        sem_destroy((sem_t*)semaphore->internal_data);
+        free(semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+void platform_semaphore_signal(platform_semaphore* semaphore)
+{
+    sem_post((sem_t*)semaphore->internal_data);
+}
+
+bool8_t platform_semaphore_wait(platform_semaphore* semaphore, uint64_t timeout_ms)
+{
+    // sem_timedwait takes an absolute CLOCK_REALTIME deadline:
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000 * 1000;
+    if (deadline.tv_nsec >= 1000 * 1000 * 1000)
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000 * 1000 * 1000;
+    }
+
+    int32_t result;
+    do
+    {
+        result = sem_timedwait((sem_t*)semaphore->internal_data, &deadline);
+    } while (result != 0 && errno == EINTR);
+
+    return result == 0;
+}
+
+bool8_t platform_file_open(const char* path, bool8_t append, platform_file* out_file)
+{
+    int32_t flags = O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC);
+    int32_t fd = open(path, flags, 0644);
+    if (fd < 0)
+    {
+        FERROR("Failed to open file '%s': %s", path, strerror(errno));
+        out_file->is_valid = FALSE;
+        return FALSE;
+    }
+
+    out_file->handle = (void*)(uint64_t)fd;
+    out_file->is_valid = TRUE;
+    return TRUE;
+}
+
+bool8_t platform_file_open_read(const char* path, platform_file* out_file)
+{
+    int32_t fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        out_file->is_valid = FALSE;
+        return FALSE;
+    }
+
+    out_file->handle = (void*)(uint64_t)fd;
+    out_file->is_valid = TRUE;
+    return TRUE;
+}
+
+void platform_file_close(platform_file* file)
+{
+    if (file->is_valid)
+    {
+        close((int32_t)(uint64_t)file->handle);
+        file->is_valid = FALSE;
+    }
+}
+
+bool8_t platform_file_write(platform_file* file, const void* data, uint64_t size)
+{
+    int32_t fd = (int32_t)(uint64_t)file->handle;
+    const uint8_t* cursor = data;
+    while (size)
+    {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return FALSE;
+        }
+        cursor += written;
+        size -= (uint64_t)written;
+    }
+    return TRUE;
+}
+
+bool8_t platform_file_size(platform_file* file, uint64_t* out_size)
+{
+    struct stat info;
+    if (fstat((int32_t)(uint64_t)file->handle, &info) != 0)
+    {
+        return FALSE;
+    }
+
+    *out_size = (uint64_t)info.st_size;
+    return TRUE;
+}
+
+bool8_t platform_file_read(platform_file* file, void* buffer, uint64_t size, uint64_t* out_read)
+{
+    int32_t fd = (int32_t)(uint64_t)file->handle;
+    uint8_t* cursor = buffer;
+    *out_read = 0;
+    while (size)
+    {
+        ssize_t count = read(fd, cursor, size);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return FALSE;
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        cursor += count;
+        size -= (uint64_t)count;
+        *out_read += (uint64_t)count;
+    }
+    return TRUE;
+}
+
+bool8_t platform_file_sync(platform_file* file)
+{
+    return fdatasync((int32_t)(uint64_t)file->handle) == 0;
+}
+
+bool8_t platform_file_rename(const char* old_path, const char* new_path)
+{
+    return rename(old_path, new_path) == 0;
+}
+
+const char* platform_get_environment_variable(const char* name)
+{
+    return getenv(name);
+}
+
 void platform_get_required_extension_names(const char*** names_darray)
 {
     darray_push(*names_darray, &"VK_KHR_xcb_surface");
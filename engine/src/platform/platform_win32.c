@@ -34,6 +34,31 @@ typedef struct internal_state
 static float64_t clock_frequency;
 static LARGE_INTEGER start_time;
 
+// Message time (ms) to platform_get_absolute_time offset, see win32_event_time:
+static float64_t message_time_offset;
+static bool8_t has_message_time_offset = FALSE;
+
+// Created on first use by platform_sleep_until:
+static HANDLE sleep_timer = 0;
+
+// Maps the time of the message being processed onto platform_get_absolute_time's clock. The two clocks are related by
+// a fixed offset plus the delivery delay, so the smallest offset seen is the best estimate of the fixed part. The
+// message time wraps every ~49.7 days, which shows up as a large jump in the offset and re-seeds it:
+static float64_t win32_event_time()
+{
+    float64_t now = platform_get_absolute_time();
+    float64_t time = (DWORD)GetMessageTime() * 0.001;
+    float64_t offset = now - time;
+    if (!has_message_time_offset || offset < message_time_offset || offset - message_time_offset > 1000.0)
+    {
+        message_time_offset = offset;
+        has_message_time_offset = TRUE;
+    }
+
+    float64_t event_time = time + message_time_offset;
+    return event_time < now ? event_time : now;
+}
+
 LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_param, LPARAM l_param)
 {
     switch (msg)
@@ -69,6 +94,7 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_param,
             keys key = (uint16_t)w_param;
 
             // Pass to the input subsystem to process:
+            input_set_event_time(win32_event_time());
             input_process_key(key, pressed);
         }
         break;
@@ -78,6 +104,7 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_param,
             int32_t x_position = GET_X_LPARAM(l_param);
             int32_t y_position = GET_Y_LPARAM(l_param);
 
+            input_set_event_time(win32_event_time());
             input_process_mouse_move(x_position, y_position);
         }
         break;
@@ -88,6 +115,7 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_param,
             {
                 // Flatten the input to an OS-independent (-1, 1);
                 zDelta = (zDelta < 0) ? -1 : 1;
+                input_set_event_time(win32_event_time());
                 input_process_mouse_wheel(zDelta); // TODO: Narrowing conversion from i32 > i8, fix this
             }
         }
@@ -120,6 +148,7 @@ LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_param,
             // Pass over to the input subsystem:
             if (mouse_button != BUTTON_MAX_BUTTONS)
             {
+                input_set_event_time(win32_event_time());
                 input_process_mouse_button(mouse_button, pressed);
             }
         }
@@ -230,6 +259,12 @@ void platform_shutdown(platform_state* plat_state)
 
     DestroyWindow(state->hwnd);
     state->hwnd = 0;
+
+    if (sleep_timer)
+    {
+        CloseHandle(sleep_timer);
+        sleep_timer = 0;
+    }
 }
 
 bool8_t platform_pump_messages(platform_state* plat_state)
@@ -308,6 +343,222 @@ void platform_sleep(uint64_t ms)
     Sleep(ms);
 }
 
+void platform_sleep_until(float64_t time)
+{
+    float64_t remaining = time - platform_get_absolute_time();
+    if (remaining <= 0)
+    {
+        return;
+    }
+
+    if (!sleep_timer)
+    {
+        // High resolution timers are not bound to the scheduler's tick (Windows 10 1803+). Fall back to a regular one:
+        sleep_timer = CreateWaitableTimerExW(0, 0, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!sleep_timer)
+        {
+            sleep_timer = CreateWaitableTimerExW(0, 0, 0, TIMER_ALL_ACCESS);
+        }
+    }
+
+    // Negative due times are relative, in 100ns units:
+    LARGE_INTEGER due_time;
+    due_time.QuadPart = -(LONGLONG)(remaining * 10000000.0);
+    if (sleep_timer && SetWaitableTimer(sleep_timer, &due_time, 0, 0, 0, FALSE))
+    {
+        WaitForSingleObject(sleep_timer, INFINITE);
+    }
+    else
+    {
+        Sleep((DWORD)(remaining * 1000.0));
+    }
+}
+
+void platform_cpu_relax()
+{
+    YieldProcessor();
+}
+
+typedef struct win32_thread
+{
+    HANDLE handle;
+    pfn_platform_thread_start start;
+    void* params;
+} win32_thread;
+
+static DWORD WINAPI win32_thread_entry(LPVOID params)
+{
+    win32_thread* thread = (win32_thread*)params;
+    return thread->start(thread->params);
+}
+
+bool8_t platform_thread_create(pfn_platform_thread_start start, void* params, platform_thread* out_thread)
+{
+    win32_thread* thread = malloc(sizeof(win32_thread));
+    thread->start = start;
+    thread->params = params;
+    thread->handle = CreateThread(0, 0, win32_thread_entry, thread, 0, 0);
+
+    if (!thread->handle)
+    {
+        FERROR("CreateThread failed.");
+        free(thread);
+        out_thread->internal_data = 0;
+        return FALSE;
+    }
+
+    out_thread->internal_data = thread;
+    return TRUE;
+}
+
+void platform_thread_join(platform_thread* thread)
+{
+    win32_thread* internal = (win32_thread*)thread->internal_data;
+    if (internal)
+    {
+        WaitForSingleObject(internal->handle, INFINITE);
+        CloseHandle(internal->handle);
+        free(internal);
+        thread->internal_data = 0;
+    }
+}
+
+bool8_t platform_semaphore_create(uint32_t initial_count, platform_semaphore* out_semaphore)
+{
+    out_semaphore->internal_data = CreateSemaphoreA(0, initial_count, 0x7FFFFFFF, 0);
+    if (!out_semaphore->internal_data)
+    {
+        FERROR("CreateSemaphore failed.");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void platform_semaphore_destroy(platform_semaphore* semaphore)
+{
+    if (semaphore->internal_data)
+    {
+        CloseHandle((HANDLE)semaphore->internal_data);
+        semaphore->internal_data = 0;
+    }
+}
+
+void platform_semaphore_signal(platform_semaphore* semaphore)
+{
+    ReleaseSemaphore((HANDLE)semaphore->internal_data, 1, 0);
+}
+
+bool8_t platform_semaphore_wait(platform_semaphore* semaphore, uint64_t timeout_ms)
+{
+    return WaitForSingleObject((HANDLE)semaphore->internal_data, (DWORD)timeout_ms) == WAIT_OBJECT_0;
+}
+
+bool8_t platform_file_open(const char* path, bool8_t append, platform_file* out_file)
+{
+    HANDLE handle = CreateFileA(path, append ? FILE_APPEND_DATA : GENERIC_WRITE, FILE_SHARE_READ, 0,
+        append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        FERROR("Failed to open file '%s': error %u", path, (uint32_t)GetLastError());
+        out_file->is_valid = FALSE;
+        return FALSE;
+    }
+
+    out_file->handle = handle;
+    out_file->is_valid = TRUE;
+    return TRUE;
+}
+
+bool8_t platform_file_open_read(const char* path, platform_file* out_file)
+{
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        out_file->is_valid = FALSE;
+        return FALSE;
+    }
+
+    out_file->handle = handle;
+    out_file->is_valid = TRUE;
+    return TRUE;
+}
+
+void platform_file_close(platform_file* file)
+{
+    if (file->is_valid)
+    {
+        CloseHandle((HANDLE)file->handle);
+        file->is_valid = FALSE;
+    }
+}
+
+bool8_t platform_file_write(platform_file* file, const void* data, uint64_t size)
+{
+    const uint8_t* cursor = data;
+    while (size)
+    {
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+        DWORD written = 0;
+        if (!WriteFile((HANDLE)file->handle, cursor, chunk, &written, 0))
+        {
+            return FALSE;
+        }
+        cursor += written;
+        size -= written;
+    }
+    return TRUE;
+}
+
+bool8_t platform_file_size(platform_file* file, uint64_t* out_size)
+{
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx((HANDLE)file->handle, &size))
+    {
+        return FALSE;
+    }
+
+    *out_size = (uint64_t)size.QuadPart;
+    return TRUE;
+}
+
+bool8_t platform_file_read(platform_file* file, void* buffer, uint64_t size, uint64_t* out_read)
+{
+    uint8_t* cursor = buffer;
+    *out_read = 0;
+    while (size)
+    {
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+        DWORD read = 0;
+        if (!ReadFile((HANDLE)file->handle, cursor, chunk, &read, 0))
+        {
+            return FALSE;
+        }
+        if (read == 0)
+        {
+            break;
+        }
+        cursor += read;
+        size -= read;
+        *out_read += read;
+    }
+    return TRUE;
+}
+
+bool8_t platform_file_sync(platform_file* file)
+{
+    return FlushFileBuffers((HANDLE)file->handle) != 0;
+}
+
+bool8_t platform_file_rename(const char* old_path, const char* new_path)
+{
+    return MoveFileExA(old_path, new_path, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+const char* platform_get_environment_variable(const char* name)
+{
+    return getenv(name);
+}
+
 void platform_get_required_extension_names(const char*** names_darray)
 {
     darray_push(*names_darray, &"VK_KHR_win32_surface");
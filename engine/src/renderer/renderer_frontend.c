@@ -1,12 +1,25 @@
+#define LOG_CATEGORY LOG_CATEGORY_RENDERER
+
 #include "renderer_frontend.h"
 #include "renderer_backend.h"
 
 #include "core/logger.h"
 #include "core/fmemory.h"
+#include "core/profiler.h"
+#include "platform/platform.h"
 
 // Backend render context: (Constrained to only one backend, might want more in the future).
 static renderer_backend* backend = 0;
 
+// Input latency of the most recent frames that had input:
+#define RENDERER_LATENCY_SAMPLES 512
+#define RENDERER_LATENCY_REPORT_INTERVAL 10.0
+
+static sample_window input_to_submit;
+static sample_window input_to_present;
+static float64_t last_latency_report = 0;
+// Input not yet accounted to a frame, e.g. because begin_frame failed for the frame it arrived in, or 0:
+static float64_t pending_input_time = 0;
 
 bool8_t renderer_initialize(const char* application_name, struct platform_state* plat_state)
 {
@@ -15,6 +28,13 @@ bool8_t renderer_initialize(const char* application_name, struct platform_state*
     // TODO: make this configurable:
     renderer_backend_create(RENDERER_BACKEND_TYPE_VULKAN, plat_state, backend);
     backend->frame_number = 0;
+    backend->submit_time = 0;
+    backend->present_time = 0;
+
+    sample_window_create(RENDERER_LATENCY_SAMPLES, &input_to_submit);
+    sample_window_create(RENDERER_LATENCY_SAMPLES, &input_to_present);
+    last_latency_report = platform_get_absolute_time();
+    pending_input_time = 0;
 
     if (!backend->initialize(backend, application_name, plat_state))
     {
@@ -29,6 +49,9 @@ void renderer_shutdown()
 {
     backend->shutdown(backend);
     ffree(backend, sizeof(renderer_backend), MEMORY_TAG_RENDERER);
+
+    sample_window_destroy(&input_to_submit);
+    sample_window_destroy(&input_to_present);
 }
 
 void renderer_on_resize(uint16_t width, uint16_t height)
@@ -48,20 +71,85 @@ bool8_t renderer_end_frame(float32_t delta_time)
     return result;
 }
 
+// Logs the latency percentiles every RENDERER_LATENCY_REPORT_INTERVAL seconds:
+static void renderer_report_input_latency(float64_t now)
+{
+    if (now - last_latency_report < RENDERER_LATENCY_REPORT_INTERVAL)
+    {
+        return;
+    }
+    last_latency_report = now;
+
+    sample_summary submit;
+    sample_summary present;
+    renderer_get_input_latency(&submit, &present);
+    if (submit.count > 0)
+    {
+        FINFO("Input to submit: p50 %.2fms, p90 %.2fms, p99 %.2fms, max %.2fms (%u frames)",
+            submit.p50 * 1000.0, submit.p90 * 1000.0, submit.p99 * 1000.0, submit.max * 1000.0, submit.count);
+    }
+    if (present.count > 0)
+    {
+        FINFO("Input to present: p50 %.2fms, p90 %.2fms, p99 %.2fms, max %.2fms (%u frames)",
+            present.p50 * 1000.0, present.p90 * 1000.0, present.p99 * 1000.0, present.max * 1000.0, present.count);
+    }
+}
+
+void renderer_get_input_latency(sample_summary* out_submit, sample_summary* out_present)
+{
+    if (out_submit)
+    {
+        sample_window_summarize(&input_to_submit, out_submit);
+    }
+    if (out_present)
+    {
+        sample_window_summarize(&input_to_present, out_present);
+    }
+}
+
 bool8_t renderer_draw_frame(render_packet* packet)
 {
+    PROFILE_FUNCTION_BEGIN();
+
+    // Input of frames that were never drawn counts towards the next frame that is:
+    if (packet->input_time > 0 && (pending_input_time == 0 || packet->input_time < pending_input_time))
+    {
+        pending_input_time = packet->input_time;
+    }
+
     // If the begin frame returned successfully, mid-frame operations may continue:
     if (renderer_begin_frame(packet->delta_time))
     {
+        float64_t input_time = pending_input_time;
+        pending_input_time = 0;
+
         // End the frame. If this fails, it is likely unrecoverable:
+        backend->submit_time = 0;
+        backend->present_time = 0;
         bool8_t result = renderer_end_frame(packet->delta_time);
         if (!result)
         {
             FERROR("renderer_end_frame failed. Application shutting down...");
+            PROFILE_ZONE_END();
             return FALSE;
         }
+
+        // Only what the backend actually did is measured:
+        if (input_time > 0)
+        {
+            if (backend->submit_time > 0)
+            {
+                sample_window_add(&input_to_submit, backend->submit_time - input_time);
+            }
+            if (backend->present_time > 0)
+            {
+                sample_window_add(&input_to_present, backend->present_time - input_time);
+            }
+        }
+        renderer_report_input_latency(platform_get_absolute_time());
     }
 
+    PROFILE_ZONE_END();
     return TRUE;
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "renderer_types.inl"
+#include "core/metrics.h"
 
 struct static_mesh_data;
 struct platform_state;
@@ -10,4 +11,12 @@ void renderer_shutdown();
 
 void renderer_on_resize(uint16_t width, uint16_t height);
 
-bool8_t renderer_draw_frame(render_packet* packet);
\ No newline at end of file
+bool8_t renderer_draw_frame(render_packet* packet);
+
+/**
+ * Summarizes the input latency of recently drawn frames, in seconds: from the earliest input of a frame to the
+ * backend submitting the frame's work to the GPU, and to the backend queuing its present. Only frames for which the
+ * backend reported the submit/present are counted, so both stay empty until it does. Frames without input are not
+ * counted, and input of frames that could not be drawn counts towards the next one. Either output can be 0/NULL.
+ */
+FAPI void renderer_get_input_latency(sample_summary* out_submit, sample_summary* out_present);
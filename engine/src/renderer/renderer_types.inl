@@ -13,6 +13,10 @@ typedef struct renderer_backend
 {
     struct platform_state* plat_state;
     uint64_t frame_number;
+    // Set by end_frame when it submits the frame's work to the GPU and when it queues the present, on the
+    // platform_get_absolute_time clock. 0 if the last end_frame did neither:
+    float64_t submit_time;
+    float64_t present_time;
 
     bool8_t (*initialize)(struct renderer_backend* backend, const char* application_name,
         struct platform_state* plat_state);
@@ -29,4 +33,6 @@ typedef struct renderer_backend
 typedef struct render_packet
 {
     float32_t delta_time;
+    // Timestamp of the earliest input processed for this frame (see input_take_earliest_event_time), or 0 if none:
+    float64_t input_time;
 } render_packet;
\ No newline at end of file
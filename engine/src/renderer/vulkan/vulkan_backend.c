@@ -1,3 +1,5 @@
+#define LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_backend.h"
 
 #include "vulkan_types.inl"
@@ -10,6 +12,7 @@
 #include "vulkan_renderpass.h"
 #include "vulkan_command_buffer.h"
 #include "core/fmemory.h"
+#include "core/profiler.h"
 
 static vulkan_context context;
 
@@ -54,7 +57,7 @@ bool8_t vulkan_renderer_backend_initialize(renderer_backend* backend, const char
     const uint32_t length = darray_length(required_extensions);
     for (int32_t i = 0; i < length; ++i)
     {
-        FDEBUG(required_extensions[i]);
+        FDEBUG("%s", required_extensions[i]);
     }
 #endif
 
@@ -79,14 +82,22 @@ bool8_t vulkan_renderer_backend_initialize(renderer_backend* backend, const char
     VkLayerProperties* available_layers = darray_reserve(VkLayerProperties, available_layer_count);
     VK_CHECK(vkEnumerateInstanceLayerProperties(&available_layer_count, available_layers));
 
+    // Scan and hash every available layer name once, so matching only compares lengths and hashes:
+    string_view* available_layer_names = darray_reserve(string_view, available_layer_count);
+    for (uint32_t j = 0; j < available_layer_count; ++j)
+    {
+        darray_push(available_layer_names, string_view_create(available_layers[j].layerName));
+    }
+
     // Verify all required layers are available:
     for (uint32_t i = 0; i < required_validation_layer_count; ++i)
     {
         FINFO("Searching for layer: %s...", required_validation_layer_names[i]);
+        string_view required_name = string_view_create(required_validation_layer_names[i]);
         bool8_t found = FALSE;
         for (uint32_t j = 0; j < available_layer_count; ++j)
         {
-            if (strings_equal(required_validation_layer_names[i], available_layers[j].layerName))
+            if (string_views_equal(required_name, available_layer_names[j]))
             {
                 found = TRUE;
                 FINFO("Found.");
@@ -97,9 +108,11 @@ bool8_t vulkan_renderer_backend_initialize(renderer_backend* backend, const char
         if (!found)
         {
             FFATAL("Required validation layer is missing: %s", required_validation_layer_names[i]);
+            darray_destroy(available_layer_names);
             return FALSE;
         }
     }
+    darray_destroy(available_layer_names);
     FINFO("All required validation layers are present.");
 #endif
 
@@ -141,21 +154,30 @@ bool8_t vulkan_renderer_backend_initialize(renderer_backend* backend, const char
     FDEBUG("Vulkan Surface Successfully Created.");
 
     // Device Creation:
-    if (!vulkan_device_create(&context))
+    PROFILE_ZONE_BEGIN("vulkan_device_create");
+    bool8_t device_created = vulkan_device_create(&context);
+    PROFILE_ZONE_END();
+    if (!device_created)
     {
         FERROR("Failed to create device!");
         return FALSE;
     }
 
     // Swapchain Creation:
+    PROFILE_ZONE_BEGIN("vulkan_swapchain_create");
     vulkan_swapchain_create(&context, context.framebuffer_width, context.framebuffer_height, &context.swapchain);
+    PROFILE_ZONE_END();
 
+    PROFILE_ZONE_BEGIN("vulkan_renderpass_create");
     vulkan_renderpass_create(&context, &context.main_renderpass, 0, 0, context.framebuffer_width,
         context.framebuffer_height, 0.0f, 0.0f, 0.2f, 1.0f, 1.0f, 0);
+    PROFILE_ZONE_END();
 
 
     // Create command buffers:
+    PROFILE_ZONE_BEGIN("create_command_buffers");
     create_command_buffers(backend);
+    PROFILE_ZONE_END();
 
     FINFO("Vulkan Renderer initialized successfully.");
     return TRUE;
@@ -163,6 +185,8 @@ bool8_t vulkan_renderer_backend_initialize(renderer_backend* backend, const char
 
 void vulkan_renderer_backend_shutdown(renderer_backend* backend)
 {
+    PROFILE_FUNCTION_BEGIN();
+
     // Destroy in the opposite order of creation:
     FINFO("Destroying Command Buffers...");
     for (uint32_t i = 0; i < context.swapchain.image_count; ++i)
@@ -202,6 +226,8 @@ void vulkan_renderer_backend_shutdown(renderer_backend* backend)
 #endif
     FDEBUG("Destroying Vulkan Instance...");
     vkDestroyInstance(context.instance, context.allocator);
+
+    PROFILE_ZONE_END();
 }
 
 void vulkan_renderer_backend_on_resized(renderer_backend* backend, uint16_t width, uint16_t height)
@@ -228,16 +254,16 @@ VKAPI_ATTR VkBool32 VKAPI_CALL vk_debug_callback(
     {
         default:
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
-            FERROR(callback_data->pMessage);
+            FERROR("%s", callback_data->pMessage);
             break;
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
-            FWARN(callback_data->pMessage);
+            FWARN("%s", callback_data->pMessage);
             break;
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
-            FINFO(callback_data->pMessage);
+            FINFO("%s", callback_data->pMessage);
             break;
             case VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT:
-            FTRACE(callback_data->pMessage);
+            FTRACE("%s", callback_data->pMessage);
             break;
     }
     return VK_FALSE;
@@ -1,3 +1,5 @@
+#define LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_device.h"
 
 #include <stdlib.h>
@@ -154,13 +156,22 @@ bool8_t physical_device_meets_requirements(
                 VK_CHECK(vkEnumerateDeviceExtensionProperties(device, 0, &available_extension_count,
                     available_extensions));
 
+                // Scan and hash every available name once, so matching only compares lengths and hashes:
+                string_view* available_names = fallocate(sizeof(string_view) * available_extension_count,
+                                                         MEMORY_TAG_STRING);
+                for (uint32_t j = 0; j < available_extension_count; ++j)
+                {
+                    available_names[j] = string_view_create(available_extensions[j].extensionName);
+                }
+
                 uint32_t required_extension_count = darray_length(requirements->device_extension_names);
                 for (uint32_t i = 0; i < required_extension_count; ++i)
                 {
+                    string_view required_name = string_view_create(requirements->device_extension_names[i]);
                     bool8_t found = FALSE;
                     for (uint32_t j = 0; j < available_extension_count; ++j)
                     {
-                        if (strings_equal(requirements->device_extension_names[i], available_extensions[j].extensionName))
+                        if (string_views_equal(required_name, available_names[j]))
                         {
                             found = TRUE;
                             break;
@@ -170,11 +181,13 @@ bool8_t physical_device_meets_requirements(
                     if (!found)
                     {
                         FINFO("Required extension not found: '%s', skipping device.", requirements->device_extension_names[i]);
+                        ffree(available_names, sizeof(string_view) * available_extension_count, MEMORY_TAG_STRING);
                         ffree(available_extensions, sizeof(VkExtensionProperties) * available_extension_count,
                             MEMORY_TAG_RENDERER);
                         return FALSE;
                     }
                 }
+                ffree(available_names, sizeof(string_view) * available_extension_count, MEMORY_TAG_STRING);
                 ffree(available_extensions, sizeof(VkExtensionProperties) * available_extension_count,
                     MEMORY_TAG_RENDERER);
             }
@@ -1,3 +1,5 @@
+#define LOG_CATEGORY LOG_CATEGORY_VULKAN
+
 #include "vulkan_image.h"
 
 #include "vulkan_device.h"
@@ -10,6 +10,8 @@ bool8_t create_game(game* out_game)
     out_game->app_config.start_pos_y = 100;
     out_game->app_config.start_width = 1280;
     out_game->app_config.start_height = 720;
+    out_game->app_config.tick_rate = 60.0f;
+    out_game->app_config.target_frame_rate = 144.0f;
     out_game->app_config.name = "Foo Engine Testbed";
     out_game->initialize = game_initialize;
     out_game->update = game_update;
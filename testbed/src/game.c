@@ -1,3 +1,5 @@
+#define LOG_CATEGORY LOG_CATEGORY_GAME
+
 #include "game.h"
 
 #include <core/logger.h>
@@ -13,7 +15,7 @@ bool8_t game_update(game* game_instance, float32_t delta_time)
     return TRUE;
 }
 
-bool8_t game_render(game* game_instance, float32_t delta_time)
+bool8_t game_render(game* game_instance, float32_t delta_time, float32_t alpha)
 {
     return TRUE;
 }
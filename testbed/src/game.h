@@ -12,6 +12,6 @@ bool8_t game_initialize(game* game_instance);
 
 bool8_t game_update(game* game_instance, float32_t delta_time);
 
-bool8_t game_render(game* game_instance, float32_t delta_time);
+bool8_t game_render(game* game_instance, float32_t delta_time, float32_t alpha);
 
 void game_on_resize(game* game_instance, uint32_t width, uint32_t height);
\ No newline at end of file
@@ -0,0 +1,70 @@
+/*
+ * Decodes a binary log written with LOG_MODE_BINARY (see core/logger.h) back to text.
+ *
+ * Usage: foo_log_decode <console.flog> [output.txt]
+ * Lines are written in timestamp order, to stdout unless an output file is given.
+ */
+
+#include <core/fmemory.h>
+#include <core/fstring.h>
+#include <core/logger.h>
+
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <binary log> [output file]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* input = fopen(argv[1], "rb");
+    if (!input)
+    {
+        fprintf(stderr, "Failed to open '%s'.\n", argv[1]);
+        return 1;
+    }
+
+    initialize_memory();
+
+    fseek(input, 0, SEEK_END);
+    long size = ftell(input);
+    fseek(input, 0, SEEK_SET);
+
+    uint8_t* data = fallocate(size > 0 ? (uint64_t)size : 1, MEMORY_TAG_ARRAY);
+    uint64_t read = fread(data, 1, size > 0 ? (uint64_t)size : 0, input);
+    fclose(input);
+
+    // Decoded text is typically a few times larger than the records:
+    string_builder text;
+    string_builder_create(0, read * 4 + 1024, &text);
+
+    int result = 0;
+    if (log_binary_decode(data, read, &text))
+    {
+        FILE* output = argc > 2 ? fopen(argv[2], "wb") : stdout;
+        if (output)
+        {
+            fwrite(text.buffer, 1, text.length, output);
+            if (output != stdout)
+            {
+                fclose(output);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Failed to open '%s'.\n", argv[2]);
+            result = 1;
+        }
+    }
+    else
+    {
+        result = 1;
+    }
+
+    string_builder_destroy(&text);
+    ffree(data, size > 0 ? (uint64_t)size : 1, MEMORY_TAG_ARRAY);
+    shutdown_memory();
+    return result;
+}